@@ -5,6 +5,10 @@ typedef struct _IO_FILE FILE;
 
 typedef void *vap_t;
 
+typedef void *vaarena_t;
+
+typedef void *vapool_t;
+
 vap_t virtalloc_new_allocator_in(size_t size, char memory[static size], int flags);
 
 vap_t virtalloc_new_allocator(size_t size, int flags);
@@ -15,8 +19,30 @@ void *virtalloc_malloc(vap_t allocator, size_t size);
 
 void virtalloc_free(vap_t allocator, void *p);
 
+void virtalloc_free_sized(vap_t allocator, void *p, size_t size);
+
+void virtalloc_free_trusted(vap_t allocator, void *p, size_t size);
+
 void *virtalloc_realloc(vap_t allocator, void *p, size_t size);
 
+void *virtalloc_calloc(vap_t allocator, size_t n, size_t size);
+
+void *virtalloc_aligned_alloc(vap_t allocator, size_t alignment, size_t size);
+
+int virtalloc_posix_memalign(vap_t allocator, void **out, size_t alignment, size_t size);
+
+size_t virtalloc_usable_size(vap_t allocator, void *p);
+
+void *virtalloc_malloc_at_least(vap_t allocator, size_t size, size_t *actual_size);
+
+int virtalloc_try_expand(vap_t allocator, void *p, size_t new_size);
+
+int virtalloc_try_shrink(vap_t allocator, void *p, size_t new_size);
+
+int virtalloc_try_malloc(vap_t allocator, size_t size, void **out);
+
+int virtalloc_try_free(vap_t allocator, void *p);
+
 void virtalloc_set_release_mechanism(vap_t allocator, void (*release_memory)(void *p));
 
 void virtalloc_unset_release_mechanism(vap_t allocator);
@@ -25,10 +51,51 @@ void virtalloc_set_request_mechanism(vap_t allocator, void *(*request_new_memory
 
 void virtalloc_unset_request_mechanism(vap_t allocator);
 
+size_t virtalloc_trim(vap_t allocator, size_t keep_bytes);
+
+int virtalloc_start_scavenger(vap_t allocator, unsigned interval_ms, size_t keep_resident_bytes, size_t reserve_bytes);
+
+void virtalloc_stop_scavenger(vap_t allocator);
+
+size_t virtalloc_get_early_release_threshold(vap_t allocator);
+
+void virtalloc_set_early_release_threshold_bounds(vap_t allocator, size_t min_size, size_t max_size);
+
+void virtalloc_set_early_release_cache_limit(vap_t allocator, size_t max_bytes);
+
+void virtalloc_get_early_release_stats(vap_t allocator, size_t *num_blocks, size_t *num_bytes);
+
+void virtalloc_get_realloc_stats(vap_t allocator, size_t *num_grown_forwards, size_t *num_grown_backwards,
+                                 size_t *num_relocated);
+
+vaarena_t virtalloc_arena_create(vap_t allocator, size_t chunk_size);
+
+void *virtalloc_arena_alloc(vaarena_t arena, size_t size);
+
+void *virtalloc_arena_realloc(vaarena_t arena, void *p, size_t old_size, size_t new_size);
+
+void *virtalloc_arena_mark(vaarena_t arena);
+
+void virtalloc_arena_reset_to_mark(vaarena_t arena, void *mark);
+
+void virtalloc_arena_destroy(vaarena_t arena);
+
+vapool_t virtalloc_pool_create(vap_t allocator, size_t object_size, size_t align);
+
+void *virtalloc_pool_alloc(vapool_t pool);
+
+void virtalloc_pool_free(vapool_t pool, void *p);
+
+void virtalloc_pool_destroy(vapool_t pool);
+
 void virtalloc_set_max_gpa_slot_checks_before_oom(vap_t allocator, size_t max_slot_checks);
 
 void virtalloc_set_max_sma_slot_checks_before_oom(vap_t allocator, size_t max_slot_checks);
 
+void virtalloc_enable_adaptive_exploration(vap_t allocator, size_t target_probes);
+
+void virtalloc_disable_adaptive_exploration(vap_t allocator);
+
 void virtalloc_dump_allocator_to_file(FILE *file, vap_t allocator);
 
 void virtalloc_enable_heavy_debug_allocator_corruption_checks(vap_t allocator);
@@ -51,6 +118,23 @@ void virtalloc_disable_heavy_debug_allocator_corruption_checks(vap_t allocator);
 #define VIRTALLOC_FLAG_VA_BUCKET_ARENAS 0x800
 #define VIRTALLOC_FLAG_VA_ASSUME_THREAD_SAFE_USAGE 0x1000  // may be used in single threaded contexts for example
 #define VIRTALLOC_FLAG_VA_HEAVY_DEBUG_CORRUPTION_CHECKS 0x2000
+#define VIRTALLOC_FLAG_VA_PAGE_MAP_CLASSIFICATION 0x4000
+#define VIRTALLOC_FLAG_VA_ADAPTIVE_EXPLORATION 0x8000
+#define VIRTALLOC_FLAG_VA_PER_THREAD_SMA 0x10000  // small allocations are served lock-free from per-thread rings
+#define VIRTALLOC_FLAG_VA_OS_BACKEND 0x20000  // memory is mapped from the OS directly (only for virtalloc_new_allocator)
+#define VIRTALLOC_FLAG_VA_HUGE_PAGES 0x40000  // like VIRTALLOC_FLAG_VA_OS_BACKEND, but backed by huge pages if possible
+#define VIRTALLOC_FLAG_VA_RESERVE_ADDRESS_SPACE 0x80000  // like VIRTALLOC_FLAG_VA_OS_BACKEND, but the heap grows in place
+#define VIRTALLOC_FLAG_VA_AUTO_TRIM 0x100000  // huge free spans are returned to the OS on free (requires an OS backend)
+#define VIRTALLOC_FLAG_VA_DYNAMIC_EARLY_RELEASE 0x200000  // freeing early release blocks raises the early release threshold
+#define VIRTALLOC_FLAG_VA_EARLY_RELEASE_CACHE 0x400000  // freed early release blocks are kept for reuse for a while
+#define VIRTALLOC_FLAG_VA_GPA_ALIGN_16 0x800000  // GPA slots are only 16 byte aligned (less internal fragmentation)
+#define VIRTALLOC_FLAG_VA_GPA_ALIGN_32 0x1000000  // GPA slots are only 32 byte aligned (less internal fragmentation)
+#define VIRTALLOC_FLAG_VA_TRUSTED_FREE 0x2000000  // frees skip the forced checksum validation (checksums are still kept)
+
+#define VIRTALLOC_TRY_OK 0
+#define VIRTALLOC_TRY_WOULD_BLOCK 1  // another thread holds a lock the operation needs, nothing was done
+#define VIRTALLOC_TRY_OUT_OF_MEMORY 2
+#define VIRTALLOC_TRY_DEFERRED 3  // the free was queued and is done by the next thread that releases the lock
 
 #define VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS (VIRTALLOC_FLAG_VA_HAS_SAFETY_CHECKS | VIRTALLOC_FLAG_VA_SMA_REQUEST_MEM_FROM_GPA | VIRTALLOC_FLAG_VA_HAS_SAFETY_PADDING_LINE | VIRTALLOC_FLAG_VA_BUCKET_ARENAS)
 
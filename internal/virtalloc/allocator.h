@@ -5,6 +5,27 @@
 #include "virtalloc/cross_platform_lock.h"
 #include "virtalloc/allocator_settings.h"
 
+/// Self-tuning exploration budget. Keeps exponentially weighted estimates of the probes per allocation, the fraction
+/// of probed slots that could not be used (occupancy) and the fraction of searches that succeeded (hit rate), and uses
+/// them to adjust max_slot_checks_before_oom and to decide whether a search that ran out of budget should grow the
+/// allocator or keep exploring. All estimates are fixed point numbers with EXPLORATION_TUNER_FIXED_POINT_SHIFT bits.
+typedef struct ExplorationTuner {
+    /// average number of probes per allocation
+    size_t avg_probes;
+    /// average fraction of probed slots that could not be used
+    size_t occupancy;
+    /// average fraction of searches that found a slot without growing the allocator
+    size_t hit_rate;
+    /// the average number of probes per allocation the tuner tries to stay under (not fixed point)
+    size_t target_probes;
+    /// the budget will never be tuned below this value
+    size_t min_budget;
+    /// the budget will never be tuned above this value, and a search that is extended is extended up to it
+    size_t max_budget;
+    /// if not set, the budget is fixed and the tuner does nothing
+    unsigned char is_enabled;
+} ExplorationTuner;
+
 /// Small allocation Round Robin Allocator. In practice, this is used for small allocations (size < 64 bytes)
 typedef struct SmallRRAllocator {
     /// how many potential slots may at most be checked before an OOM (out of memory -> request more) is triggered
@@ -15,8 +36,20 @@ typedef struct SmallRRAllocator {
     void *last_slot;
     /// the last slot that was converted from free to allocated
     void *rr_slot;
+    /// tunes max_slot_checks_before_oom if enabled
+    ExplorationTuner tuner;
 } SmallRRAllocator;
 
+/// a small allocation ring owned by a single thread (see VIRTALLOC_FLAG_VA_PER_THREAD_SMA). Only the owner allocates
+/// from it, which it does without taking the allocator lock. Any thread may free slots of the ring by atomically
+/// setting their free bit. Rings of exited threads are abandoned (owner is NULL) and get adopted by other threads.
+typedef struct ThreadRing {
+    /// the ring itself, only ever modified by the owning thread (or under the allocator lock if it has no owner)
+    SmallRRAllocator sma;
+    /// the thread state of the owning thread or NULL if the ring is not owned. Only accessed atomically.
+    void *owner;
+} __attribute__((aligned(64))) ThreadRing;  // 64 is cache line size
+
 typedef struct GPBucketTreeNode {
     /// a leaf node is level 0, root node is level N (where tree has 2^N leaf nodes)
     size_t level;
@@ -34,12 +67,20 @@ typedef struct GeneralPurposeAllocator {
     size_t max_slot_checks_before_oom;
     /// a linked list connecting one slot to the previous and next one
     void *first_slot;
+    /// the alignment of all slot data pointers and the granule all slot sizes are rounded to (between MIN_GPA_ALIGN and
+    /// LARGE_ALLOCATION_ALIGN). Also the spacing of the buckets.
+    size_t alignment;
     /// number of buckets in bucket_sizes/bucket_pointers
     size_t num_buckets;
     /// num buckets rounded to next power of 2 (for bucket tree internals)
     size_t rounded_num_buckets_pow_2;
-    /// at this size or greater, a slot will be released early and not re-used to save resources
+    /// at this size or greater, a slot will be released early and not re-used to save resources. Only accessed
+    /// atomically because free may raise it without holding a lock.
     size_t min_size_for_early_release;
+    /// freeing an early release block smaller than this raises min_size_for_early_release above the block's size, so
+    /// that allocations of that size are served from the GPA afterwards. 0 if the threshold is fixed. Only accessed
+    /// atomically.
+    size_t max_dynamic_early_release_size;
     /// buckets that slice into the linked list of free slots sorted from smallest to biggest by slot size
     size_t *bucket_sizes;
     /// the smallest free slot that falls into a given bucket category. size is num_buckets.
@@ -48,16 +89,82 @@ typedef struct GeneralPurposeAllocator {
     /// "this value counts for all child nodes, don't even look at those", which turns an addition or removal of an
     /// entry from N writes into at most log(N)
     GPBucketTreeNode *bucket_tree;
+    /// tunes max_slot_checks_before_oom if enabled
+    ExplorationTuner tuner;
 } GeneralPurposeAllocator;
 
+/// recently freed early release blocks that are kept around instead of being released, so that allocations of a similar
+/// size can reuse them without a round trip to the backing allocator. The blocks are grouped by the largest power of 2
+/// that fits into them. Each group is a list ordered by the time its blocks were cached, linked through the blocks'
+/// data. Only accessed while holding the backing lock.
+typedef struct EarlyReleaseCache {
+    /// the most recently cached block of each size class (reused first)
+    struct EarlyReleaseCacheEntry *newest[EARLY_RELEASE_CACHE_NUM_CLASSES];
+    /// the least recently cached block of each size class (evicted first)
+    struct EarlyReleaseCacheEntry *oldest[EARLY_RELEASE_CACHE_NUM_CLASSES];
+    /// bit i is set if size class i has cached blocks
+    size_t nonempty_classes;
+    /// total data size of all cached blocks
+    size_t cached_bytes;
+    /// cached_bytes never exceeds this (0 disables the cache)
+    size_t max_bytes;
+    /// counts early release mallocs and frees, which is the clock blocks age by
+    size_t tick;
+} EarlyReleaseCache;
+
+/// the independently locked parts of an allocator, passed as a mask to pre_alloc_op and post_alloc_op
+#define ALLOCATOR_PART_SMA 0x1
+#define ALLOCATOR_PART_GPA 0x2
+#define ALLOCATOR_PART_BACKING 0x4
+#define ALLOCATOR_PART_ALL (ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA | ALLOCATOR_PART_BACKING)
+
 /// the internal per-allocator data stored in the first sizeof(VA) bytes of the heap
 typedef struct Allocator {
     /// the main allocator that is used by default
     GeneralPurposeAllocator gpa;
     /// a special purpose allocator for small allocations (size < MIN_LARGE_ALLOCATION_SIZE)
     SmallRRAllocator sma;
-    /// lock for multithreaded allocators
-    ThreadLock lock;
+    /// per-thread small allocation rings (NULL if VIRTALLOC_FLAG_VA_PER_THREAD_SMA is not set)
+    ThreadRing *thread_rings;
+    /// number of entries in thread_rings. Threads that find no unowned ring fall back to the shared SMA.
+    size_t num_thread_rings;
+    /// end of the address space reserved for the heap (NULL if the allocator has no reservation). The heap starts at
+    /// the allocator itself and grows by committing more of the reservation, so it stays contiguous.
+    void *reserved_end;
+    /// end of the committed part of the reservation (only modified while holding the backing lock)
+    void *committed_end;
+    /// protects the shared SMA (and the adoption of abandoned thread rings). Always locked before gpa_lock.
+    ThreadLock sma_lock;
+    /// protects the GPA's slots, free list and buckets. Always locked after sma_lock and before backing_lock.
+    ThreadLock gpa_lock;
+    /// serializes calls to request_new_memory and release_memory, which need not be thread safe. Always locked last.
+    ThreadLock backing_lock;
+    /// how often the GPA lock is currently held by its owner (only accessed while holding the GPA lock)
+    int gpa_lock_depth;
+    /// how often the backing lock is currently held by its owner (only accessed while holding the backing lock)
+    int backing_lock_depth;
+    /// lock-free stack of GPA slots whose free was deferred because try_free could not get the GPA lock. The stack is
+    /// linked through the first word of each slot's data and drained by the next thread releasing the GPA lock.
+    void *deferred_gpa_frees;
+    /// like deferred_gpa_frees, but for early release blocks (drained by the next thread releasing the backing lock)
+    void *deferred_backing_frees;
+    /// the first block of the list of live (allocated) early release blocks. Only accessed while holding the backing
+    /// lock.
+    struct GPEarlyReleaseMeta *early_release_blocks;
+    /// number of blocks in early_release_blocks
+    size_t num_early_release_blocks;
+    /// total data size of the blocks in early_release_blocks
+    size_t early_release_bytes;
+    /// early release blocks that were freed but not released yet
+    EarlyReleaseCache early_release_cache;
+    /// the background thread trimming and refilling the GPA (NULL if none was started)
+    struct Scavenger *scavenger;
+    /// number of reallocs that grew a GPA slot in place into its free successor (atomically updated)
+    size_t num_reallocs_grown_forwards;
+    /// number of reallocs that grew a GPA slot by merging it with its free predecessor (atomically updated)
+    size_t num_reallocs_grown_backwards;
+    /// number of reallocs that had to relocate the data to a new allocation (atomically updated)
+    size_t num_reallocs_relocated;
 
     /// allocation function
     void *(*malloc)(struct Allocator *allocator, size_t size, int is_retry_run);
@@ -72,7 +179,8 @@ typedef struct Allocator {
     void (*gpa_add_new_memory)(struct Allocator *allocator, void *p, size_t size);
 
     /// the function used to give the round-robin small allocator new memory it can use (assumed to be free initially)
-    void (*sma_add_new_memory)(struct Allocator *allocator, void *p, size_t size, int must_free_later);
+    void (*sma_add_new_memory)(struct Allocator *allocator, SmallRRAllocator *sma, void *p, size_t size,
+                               int must_free_later);
 
     /// callback used when the VA is released: it is called on each owned memory slot (can be `free` for example)
     void (*release_memory)(void *p);
@@ -84,34 +192,31 @@ typedef struct Allocator {
     /// information at any point.
     void *(*request_new_memory)(size_t min_size);
 
-    /// a callback invoked *before* an allocator operation (one of the callbacks defined below)
-    void (*pre_alloc_op)(struct Allocator *allocator);
+    /// a callback invoked *before* an allocator operation on the given parts (a mask of ALLOCATOR_PART_*)
+    void (*pre_alloc_op)(struct Allocator *allocator, int parts);
 
-    /// a callback invoked *after* an allocator operation (one of the callbacks defined below)
-    void (*post_alloc_op)(struct Allocator *allocator);
+    /// a callback invoked *after* an allocator operation on the given parts (a mask of ALLOCATOR_PART_*)
+    void (*post_alloc_op)(struct Allocator *allocator, int parts);
 
     /// decides how many bytes of padding should be added after an allocated slot to make the allocator more robust
     /// against off-by-1 errors and similar user-made bugs that may interfere with heap metadata. The way this is
     /// implemented is really simple - you literally just add this number times ALIGN to the size of every allocation.
     size_t (*get_gpa_padding_lines)(size_t allocation_size);
 
-    /// the number of times the allocator has been locked. The global lock will be released when this count reaches 0.
-    /// Note that this counter is only used within a thread to keep track of the lock/unlock counts and is thread safe
-    /// despite not being atomic because it is only modified in code passages where the allocator is locked already.
-    int intra_thread_lock_count;
     /// how many get_meta calls to do before get_meta checks the checksum once
     int steps_per_checksum_check;
     /// how many bytes the data pointer has been right adjusted to match the alignment requirements
     unsigned char memory_pointer_right_adjustment;
+    /// if set, when destroying a VA, the release will not traverse the entire heap and instead only call
+    /// allocator->release_memory on the allocator itself. Not a bitfield because it is written while other threads may
+    /// read the bitfield flags below without holding the lock.
+    unsigned char release_only_allocator;
     /// whether the allocator should compute the checksum for the metadata
     unsigned char has_checksum: 1;
     /// whether to enable some basic safety checks or not
     unsigned char enable_safety_checks: 1;
     /// set only if the VA's underlying memory is owned (used in free_virtual_allocator for user foot gun protection)
     unsigned char memory_is_owned: 1;
-    /// if set, when destroying a VA, the release will not traverse the entire heap and instead only call
-    /// allocator->release_memory on the allocator itself
-    unsigned char release_only_allocator: 1;
     /// may be set if the user guarantees thread safe usage of the allocator to remove the global allocator lock
     unsigned char assume_thread_safe_usage: 1;
     /// if set, disables the round-robin allocator for small allocations
@@ -123,10 +228,32 @@ typedef struct Allocator {
     unsigned char sma_request_mem_from_gpa: 1;
     /// if set, enables very heavy corruption checks on every malloc/realloc/free call. Useful for debugging only.
     unsigned char debug_corruption_checks: 1;
+    /// if set, pointers are classified through the process-wide page map instead of reading the meta type in front of
+    /// them. All regions are then page aligned so that every registered page belongs to exactly one region.
+    unsigned char use_page_map: 1;
+    /// if set, small allocations are served lock-free from per-thread rings (see ThreadRing)
+    unsigned char per_thread_sma: 1;
+    /// set if all memory of the allocator is anonymous memory mapped by the built-in OS backend, which is required to
+    /// decommit the pages of free slots
+    unsigned char can_decommit: 1;
+    /// if set, free returns the pages of huge free spans to the OS right away (see VIRTALLOC_FLAG_VA_AUTO_TRIM)
+    unsigned char auto_trim: 1;
+    /// if set, all frees are trusted to pass valid pointers, so they skip the forced checksum validation
+    unsigned char trusted_free: 1;
     /// decides what type of bucket strategy to use (none, tree, arena)
     unsigned char bucket_strategy;
 } __attribute__((aligned(LARGE_ALLOCATION_ALIGN))) Allocator;
 
+/// locks the given parts (a mask of ALLOCATOR_PART_*) in the global lock order SMA -> GPA -> backing
+void lock_allocator_parts(Allocator *allocator, int parts);
+
+/// unlocks the given parts (a mask of ALLOCATOR_PART_*) in reverse lock order
+void unlock_allocator_parts(Allocator *allocator, int parts);
+
+/// like lock_allocator_parts, but never blocks. Returns nonzero if all parts were locked and zero (with no part
+/// locked) if any of them is held by another thread.
+int try_lock_allocator_parts(Allocator *allocator, int parts);
+
 void lock_virtual_allocator(Allocator *allocator);
 
 void unlock_virtual_allocator(Allocator *allocator);
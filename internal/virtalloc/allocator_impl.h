@@ -12,18 +12,56 @@ void *virtalloc_malloc_impl(Allocator *allocator, size_t size, int is_retry_run)
 
 void virtalloc_free_impl(Allocator *allocator, void *p);
 
+/// like free, but the caller passes the size it allocated (0 if unknown), which is checked against the allocation and
+/// lets trusted frees classify p without the page map. If trusted is set, the forced checksum validation is skipped.
+void virtalloc_free_sized_impl(Allocator *allocator, void *p, size_t size, int trusted);
+
 void *virtalloc_realloc_impl(Allocator *allocator, void *p, size_t size);
 
+/// allocates n * size zeroed bytes (NULL on overflow). Only zeroes what is not known to be zero-filled already.
+void *virtalloc_calloc_impl(Allocator *allocator, size_t n, size_t size);
+
+/// allocates size bytes aligned to alignment (a power of 2). Returns NULL if alignment is not a power of 2.
+void *virtalloc_aligned_alloc_impl(Allocator *allocator, size_t alignment, size_t size);
+
+/// grows (or, if shrink is set, shrinks) the allocation at p to size without moving it. Returns 1 on success and 0 if
+/// that is not possible, in which case nothing was done. Growing to a smaller size succeeds without shrinking.
+int virtalloc_resize_in_place_impl(Allocator *allocator, void *p, size_t size, int shrink);
+
+/// returns how many bytes of the allocation at p may be used, which may be more than were requested
+size_t virtalloc_usable_size_impl(Allocator *allocator, void *p);
+
+/// like malloc, but returns VIRTALLOC_TRY_WOULD_BLOCK instead of waiting for a lock held by another thread
+int virtalloc_try_malloc_impl(Allocator *allocator, size_t size, void **out);
+
+/// like free, but defers the free to the next holder of the required lock instead of waiting for it
+int virtalloc_try_free_impl(Allocator *allocator, void *p);
+
+/// returns the memory of free GPA slots to the OS until at most keep_bytes of free memory stay resident. Regions that
+/// have become entirely free are only released if release_regions is set, otherwise they are decommitted. Returns the
+/// number of bytes returned.
+size_t virtalloc_trim_impl(Allocator *allocator, size_t keep_bytes, int release_regions);
+
+/// returns the total size of all free GPA slots (including decommitted ones)
+size_t get_gpa_free_bytes(Allocator *allocator);
+
+/// requests new memory for the GPA if it has less than reserve_bytes of free memory. Returns 1 if memory was added.
+int refill_gpa_reserve(Allocator *allocator, size_t reserve_bytes);
+
+/// frees all pointers whose free was deferred by virtalloc_try_free_impl
+void virtalloc_drain_deferred_frees_impl(Allocator *allocator);
+
 /// gets called when the allocator enters a critical section (non-threadsafe section)
-void virtalloc_pre_op_callback_impl(Allocator *allocator);
+void virtalloc_pre_op_callback_impl(Allocator *allocator, int parts);
 
 /// gets called when the allocator exits a critical section (non-threadsafe section)
-void virtalloc_post_op_callback_impl(Allocator *allocator);
+void virtalloc_post_op_callback_impl(Allocator *allocator, int parts);
 
 /// transfers ownership of the given memory to the allocator
 void virtalloc_gpa_add_new_memory_impl(Allocator *allocator, void *p, size_t size);
 
-/// transfers ownership of the given memory to the allocator
-void virtalloc_sma_add_new_memory_impl(Allocator *allocator, void *p, size_t size, int must_free_later);
+/// transfers ownership of the given memory to the allocator (appends it to the ring of the given SMA)
+void virtalloc_sma_add_new_memory_impl(Allocator *allocator, SmallRRAllocator *sma, void *p, size_t size,
+                                       int must_free_later);
 
 #endif
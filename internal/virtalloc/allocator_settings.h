@@ -13,10 +13,76 @@
 #define LARGE_ALLOCATION_ALIGN ((MIN_LARGE_ALLOCATION_SIZE) < 64 ? (MIN_LARGE_ALLOCATION_SIZE) : 64)  // 64 is cache line size
 #endif
 
+#ifndef MIN_GPA_ALIGN  // this ifndef is to allow the user to define these in the build system
+#define MIN_GPA_ALIGN ((LARGE_ALLOCATION_ALIGN) < 16 ? (LARGE_ALLOCATION_ALIGN) : 16)  // smallest selectable GPA alignment
+#endif
+
 #ifndef MIN_NEW_MEM_REQUEST_SIZE  // this ifndef is to allow the user to define these in the build system
 #define MIN_NEW_MEM_REQUEST_SIZE (1024 * 1024)
 #endif
 
+#ifndef PAGE_MAP_PAGE_SIZE  // this ifndef is to allow the user to define these in the build system
+#define PAGE_MAP_PAGE_SIZE 4096  // granularity of the page map used for pointer classification (must be a power of 2)
+#endif
+
+#ifndef OS_PAGE_SIZE  // this ifndef is to allow the user to define these in the build system
+#define OS_PAGE_SIZE 4096  // granularity of the memory the built-in OS backend maps
+#endif
+
+#ifndef OS_HUGE_PAGE_SIZE  // this ifndef is to allow the user to define these in the build system
+#define OS_HUGE_PAGE_SIZE (2 * 1024 * 1024)  // granularity of the memory the built-in OS backend maps with huge pages
+#endif
+
+#ifndef RESERVED_ADDRESS_SPACE_SIZE  // this ifndef is to allow the user to define these in the build system
+#define RESERVED_ADDRESS_SPACE_SIZE ((size_t) 64 * 1024 * 1024 * 1024)  // see VIRTALLOC_FLAG_VA_RESERVE_ADDRESS_SPACE
+#endif
+
+#ifndef TRIM_MIN_DECOMMIT_SIZE  // this ifndef is to allow the user to define these in the build system
+#define TRIM_MIN_DECOMMIT_SIZE (64 * 1024)  // free slots with fewer whole pages than this are not worth trimming
+#endif
+
+#ifndef AUTO_TRIM_MIN_SLOT_SIZE  // this ifndef is to allow the user to define these in the build system
+#define AUTO_TRIM_MIN_SLOT_SIZE (16 * 1024 * 1024)  // see VIRTALLOC_FLAG_VA_AUTO_TRIM
+#endif
+
+#ifndef REALLOC_GROWTH_STREAK_FOR_HEADROOM  // this ifndef is to allow the user to define these in the build system
+#define REALLOC_GROWTH_STREAK_FOR_HEADROOM 2  // realloc reserves headroom once an allocation grew this often in a row
+#endif
+
+#ifndef REALLOC_MAX_HEADROOM  // this ifndef is to allow the user to define these in the build system
+#define REALLOC_MAX_HEADROOM (256 * 1024)  // the most headroom realloc reserves for the predicted growth of a slot
+#endif
+
+#define ARENA_ALLOCATION_ALIGN 16  // arena allocations are aligned like malloc'd memory (max_align_t)
+#define ARENA_MIN_CHUNK_SIZE 4096
+
+#ifndef POOL_SLAB_SIZE  // this ifndef is to allow the user to define these in the build system
+#define POOL_SLAB_SIZE (64 * 1024)  // pool slabs are aligned to their size (must be a power of 2)
+#endif
+#define POOL_DEFAULT_ALIGN 16
+
+#ifndef NON_TEMPORAL_COPY_MIN_SIZE  // this ifndef is to allow the user to define these in the build system
+#define NON_TEMPORAL_COPY_MIN_SIZE (1024 * 1024)  // relocating reallocs copying less than this use memcpy
+#endif
+
+#ifndef DYNAMIC_EARLY_RELEASE_MAX_SIZE  // this ifndef is to allow the user to define these in the build system
+#define DYNAMIC_EARLY_RELEASE_MAX_SIZE (32 * 1024 * 1024)  // see VIRTALLOC_FLAG_VA_DYNAMIC_EARLY_RELEASE
+#endif
+
+#ifndef EARLY_RELEASE_SIZE_CLASSES_PER_DOUBLING  // this ifndef is to allow the user to define these in the build system
+#define EARLY_RELEASE_SIZE_CLASSES_PER_DOUBLING 4  // early release sizes are rounded to 1/4 steps (must be a power of 2)
+#endif
+
+#ifndef EARLY_RELEASE_CACHE_MAX_BYTES  // this ifndef is to allow the user to define these in the build system
+#define EARLY_RELEASE_CACHE_MAX_BYTES (64 * 1024 * 1024)  // see VIRTALLOC_FLAG_VA_EARLY_RELEASE_CACHE
+#endif
+
+#ifndef EARLY_RELEASE_CACHE_MAX_AGE  // this ifndef is to allow the user to define these in the build system
+#define EARLY_RELEASE_CACHE_MAX_AGE 1024  // cached blocks are released after this many early release mallocs and frees
+#endif
+
+#define EARLY_RELEASE_CACHE_NUM_CLASSES 64  // one size class per power of 2
+
 #define EARLY_RELEASE_SIZE_TINY   (   4 * 1024)
 #define EARLY_RELEASE_SIZE_SMALL  (  32 * 1024)
 #define EARLY_RELEASE_SIZE_NORMAL ( 128 * 1024)
@@ -33,6 +99,20 @@
 
 #define DEFAULT_EXPLORATION_STEPS_BEFORE_RR_OOM 64
 
+#ifndef NUM_THREAD_RINGS  // this ifndef is to allow the user to define these in the build system
+#define NUM_THREAD_RINGS 16  // how many per-thread SMA rings an allocator has (if per-thread SMA is enabled)
+#endif
+
+#define THREAD_RING_CACHE_SIZE 8  // how many allocators a thread can hold a ring of at the same time
+
+#define EXPLORATION_TUNER_FIXED_POINT_SHIFT 8
+#define EXPLORATION_TUNER_EWMA_SHIFT 4  // every new sample has a weight of 1/16
+#define DEFAULT_EXPLORATION_TARGET_PROBES 8
+#define DEFAULT_MIN_EXPLORATION_STEPS 4
+#define DEFAULT_MAX_EXPLORATION_STEPS 1024
+#define EXPLORATION_TUNER_GROW_OCCUPANCY_NUM 7  // grow if more than 7/8 of the probed slots were unusable
+#define EXPLORATION_TUNER_GROW_OCCUPANCY_DEN 8
+
 #define NO_BUCKETS 0
 #define BUCKET_TREE 1
 #define BUCKET_ARENAS 2
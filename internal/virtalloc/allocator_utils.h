@@ -12,6 +12,8 @@
 
 void dump_gp_slot_meta_to_file(FILE *file, GPMemorySlotMeta *meta, size_t slot_num);
 
+void dump_early_release_meta_to_file(FILE *file, GPEarlyReleaseMeta *meta, size_t block_num);
+
 void dump_sm_slot_meta_to_file(FILE *file, SmallRRMemorySlotMeta *meta, size_t slot_num);
 
 size_t get_bucket_index(const Allocator *allocator, size_t size);
@@ -22,13 +24,32 @@ void *get_bucket_entry(const Allocator *allocator, size_t bucket_idx);
 
 void validate_checksum_of(const Allocator *allocator, void *meta, int force_validate);
 
+unsigned char get_meta_type(const Allocator *allocator, void *p);
+
 GPMemorySlotMeta *get_meta(const Allocator *allocator, void *p, int should_be_free);
 
 GPEarlyReleaseMeta *get_early_rel_meta(const Allocator *allocator, void *p);
 
+/// whether an early release block with a data section of block_size bytes should be used for size bytes: it must fit,
+/// and it must not waste a whole size class step
+int is_early_release_block_fit_for(size_t block_size, size_t size);
+
 void *get_next_rr_slot(const Allocator *allocator, void *rr_slot);
 
-void coalesce_memory_slots(Allocator *allocator, GPMemorySlotMeta *meta, int meta_requires_unbind_from_free_list);
+/// atomically reads the meta of a small slot (slots may be freed by other threads without holding the lock)
+SmallRRMemorySlotMeta load_rr_slot_meta(const SmallRRMemorySlotMeta *meta);
+
+/// whether p may point into the allocator's heap. With a reservation, this is a range check against the committed part
+/// of it (which contains every GPA and SMA slot), otherwise it is always true.
+int is_in_reserved_heap(const Allocator *allocator, const void *p);
+
+/// atomically marks a small slot as free or allocated
+void set_rr_slot_is_free(SmallRRMemorySlotMeta *meta, int is_free);
+
+/// merges a free slot with its free, contiguous neighbours (except across owned region boundaries) and returns the meta
+/// of the merged slot
+GPMemorySlotMeta *coalesce_memory_slots(Allocator *allocator, GPMemorySlotMeta *meta,
+                                        int meta_requires_unbind_from_free_list);
 
 void unbind_from_sorted_free_list(Allocator *allocator, GPMemorySlotMeta *meta);
 
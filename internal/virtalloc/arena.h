@@ -0,0 +1,49 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "virtalloc/allocator.h"
+#include "virtalloc/allocator_settings.h"
+
+/// a chunk of an arena, requested from the parent allocator. The allocations follow the header.
+typedef struct ArenaChunk {
+    /// the chunk that was filled before this one (NULL for the first one)
+    struct ArenaChunk *prev;
+    /// the end of the chunk's data
+    void *end;
+} __attribute__((aligned(ARENA_ALLOCATION_ALIGN))) ArenaChunk;
+
+/// a bump allocator whose chunks come from a parent allocator. Not thread safe.
+typedef struct Arena {
+    /// the allocator the arena and its chunks are allocated from
+    Allocator *allocator;
+    /// the data size of a regular chunk (bigger allocations get a chunk of their own)
+    size_t chunk_size;
+    /// the chunk allocations are currently bumped from (NULL if the arena has no chunk)
+    ArenaChunk *current;
+    /// where the next allocation starts in the current chunk
+    void *cursor;
+} Arena;
+
+/// creates an arena whose chunks have chunk_size bytes of data (at least ARENA_MIN_CHUNK_SIZE). Returns NULL if
+/// chunk_size is too big or the arena could not be allocated.
+Arena *arena_create(Allocator *allocator, size_t chunk_size);
+
+/// returns size bytes aligned to ARENA_ALLOCATION_ALIGN, or NULL if size is too big to align or no new chunk could be
+/// allocated
+void *arena_alloc(Arena *arena, size_t size);
+
+/// grows or shrinks the allocation p of old_size bytes to new_size bytes. If p is the most recent allocation and the
+/// chunk has enough room, it is resized in place. Other allocations are shrunk in place without giving memory back, and
+/// grown by copying the data to a new allocation. Returns NULL (and
+/// leaves p untouched) if new_size is too big or no new chunk could be allocated.
+void *arena_realloc(Arena *arena, void *p, size_t old_size, size_t new_size);
+
+/// frees all allocations made after mark was taken (see Arena.cursor) by returning the chunks that were filled since to
+/// the parent allocator. A NULL mark frees all allocations.
+void arena_reset_to_mark(Arena *arena, void *mark);
+
+/// frees all chunks and the arena itself
+void arena_destroy(Arena *arena);
+
+#endif
@@ -24,6 +24,9 @@ void destroy_lock(ThreadLock *lock);
 
 void lock(ThreadLock *lock);
 
+/// returns nonzero if the lock was acquired, zero if another thread holds it
+int try_lock(ThreadLock *lock);
+
 void unlock(ThreadLock *lock);
 
 #endif
@@ -0,0 +1,24 @@
+#ifndef EARLY_RELEASE_CACHE_H
+#define EARLY_RELEASE_CACHE_H
+
+#include <stddef.h>
+#include "virtalloc/allocator.h"
+#include "virtalloc/gp_memory_slot_meta.h"
+
+// all functions below must be called while holding the backing lock
+
+/// removes and returns the most recently cached block that is a good fit for size bytes (see
+/// is_early_release_block_fit_for), or NULL if there is none. Also releases blocks that have aged out.
+GPEarlyReleaseMeta *early_release_cache_take(Allocator *allocator, size_t size);
+
+/// caches a freed early release block instead of releasing it, evicting the oldest blocks if the cache would grow
+/// beyond its limit. Returns 0 if the block was not cached (and must thus be released by the caller).
+int early_release_cache_put(Allocator *allocator, GPEarlyReleaseMeta *meta);
+
+/// changes the maximum total data size of the cached blocks, evicting the oldest blocks until it is respected
+void early_release_cache_set_limit(Allocator *allocator, size_t max_bytes);
+
+/// releases all cached blocks and returns their total data size
+size_t early_release_cache_flush(Allocator *allocator);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef EXPLORATION_TUNER_H
+#define EXPLORATION_TUNER_H
+
+#include <stddef.h>
+#include "virtalloc/allocator.h"
+
+/// enables the tuner and resets its estimates and the budget it controls
+void exploration_tuner_enable(ExplorationTuner *tuner, size_t *budget, size_t target_probes);
+
+/// records the outcome of one search (`probes` slots were checked, `misses` of which were unusable) and adjusts the
+/// budget so that the average number of probes per allocation stays under the target
+void exploration_tuner_record(ExplorationTuner *tuner, size_t *budget, size_t probes, size_t misses, int hit);
+
+/// decides whether a search that ran out of budget should grow the allocator (returns 1) or keep exploring because the
+/// allocator is estimated to have plenty of usable slots and the miss was likely just a local cluster (returns 0)
+int exploration_tuner_should_grow(const ExplorationTuner *tuner, size_t probes);
+
+#endif
@@ -27,21 +27,30 @@ typedef struct GPMemorySlotMeta {
     void *next_bigger_free;
     /// points to the slot start of the next smaller free memory slot (may also be the same size)
     void *next_smaller_free;
-    /// how many bytes the data pointer has been right adjusted to match the alignment requirements
-    unsigned char memory_pointer_right_adjustment;
+    /// how many bytes the data pointer has been right adjusted to match the alignment requirements (up to a page)
+    unsigned short memory_pointer_right_adjustment;
     /// whether it is a free slot or allocated
     unsigned char is_free: 1;
     /// whether to call the allocator->release_memory callback on this slot on allocator destruction or not
     unsigned char memory_is_owned: 1;
+    /// whether the pages in the page aligned interior of the data section are known to be zero-filled because they have
+    /// been returned to the OS or were never touched since they were mapped. Set by trimming free slots and for fresh OS
+    /// memory, inherited when the slot is split and cleared when it is freed again or when calloc consumes it.
+    unsigned char is_decommitted: 1;
     /// bitfield-level padding for the bitfield above (so it doesn't become uninitialized memory)
-    unsigned char __bit_padding1: 6;
+    unsigned char __bit_padding1: 5;
+    /// how many times in a row realloc has grown this allocation (saturating). Used to predict further growth.
+    unsigned char growth_streak;
+    /// how much of the data section (in units of MIN_GPA_ALIGN) lies beyond the size of the last realloc, e.g. because
+    /// realloc reserved headroom for predicted growth. Growing into it needs no work, shrinking starts below it.
+    unsigned short unrequested_size;
     /// byte level padding
-    char __padding[5];
+    char __padding[1];
     /// bitfield-level padding for the meta type
     unsigned char __bit_padding2: 1;
     /// a type identifier for a reflection-like mechanism in the allocator. Always 1 for this struct type.
     unsigned char meta_type: 7;
-} __attribute__((aligned(LARGE_ALLOCATION_ALIGN))) GPMemorySlotMeta;
+} __attribute__((aligned(MIN_GPA_ALIGN))) GPMemorySlotMeta;
 
 typedef struct GPEarlyReleaseMeta {
     /// how many get_meta calls on this have to be done before get_meta checks the checksum again
@@ -52,8 +61,17 @@ typedef struct GPEarlyReleaseMeta {
     void *data;
     /// size of this slot's data section
     size_t size;
+    /// the previous block in the allocator's list of live early release blocks (NULL for the first one)
+    struct GPEarlyReleaseMeta *prev_block;
+    /// the next block in the allocator's list of live early release blocks (NULL for the last one)
+    struct GPEarlyReleaseMeta *next_block;
+    /// whether the data section is known to be zero-filled (the block was freshly mapped by the OS backend). Cleared
+    /// when the block is freed or when calloc consumes it.
+    unsigned char is_zero_filled: 1;
+    /// bitfield-level padding for the bitfield above (so it doesn't become uninitialized memory)
+    unsigned char __bit_padding1: 7;
     /// byte level padding
-    char __padding[39];
+    char __padding[22];
     /// bitfield-level padding for the meta type
     unsigned char __bit_padding2: 1;
     /// a type identifier for a reflection-like mechanism in the allocator. Always 2 for this struct type.
@@ -71,7 +89,7 @@ typedef struct GenericGPMeta {
     unsigned char __bit_padding2: 1;
     /// a type identifier for a reflection-like mechanism in the allocator. Always 2 for this struct type.
     unsigned char meta_type: 7;
-} __attribute__((aligned(LARGE_ALLOCATION_ALIGN))) GenericGPMeta;
+} __attribute__((aligned(MIN_GPA_ALIGN))) GenericGPMeta;
 
 int get_checksum(const void *meta);
 
@@ -4,11 +4,16 @@
 #include <stddef.h>
 
 #define align_to(size, align) ((((size) + (align) - 1) / (align)) * (align))
+#define align_down(size, align) ((size) / (align) * (align))
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #define max(a, b) ((a) < (b) ? (b) : (a))
 
 size_t round_to_power_of_2(size_t x);
 
+/// rounds x up to the next size class, where every doubling of the size is split into classes_per_doubling equally
+/// sized steps (classes_per_doubling must be a power of 2)
+size_t round_to_size_class(size_t x, size_t classes_per_doubling);
+
 int ilog2l(size_t value);
 
 #endif
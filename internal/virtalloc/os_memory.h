@@ -0,0 +1,36 @@
+#ifndef OS_MEMORY_H
+#define OS_MEMORY_H
+
+#include <stddef.h>
+
+/// request_new_memory implementation that maps memory directly from the OS. Follows the request protocol, i.e. the
+/// granted size (min_size rounded up to whole pages) is written to the first 8 bytes of the returned memory.
+void *os_request_memory(size_t min_size);
+
+/// like os_request_memory, but rounds the size to whole huge pages and tries to back the memory with huge pages,
+/// either explicitly (MAP_HUGETLB) or, if no huge pages are reserved, through transparent huge pages. Requests smaller
+/// than half a huge page are served like os_request_memory.
+void *os_request_huge_page_memory(size_t min_size);
+
+/// reserves reserve_size bytes of address space without backing them with memory and commits the first commit_size
+/// bytes of it. Follows the request protocol for the committed part and writes the end of the reservation to
+/// *reserved_end. The whole reservation is released with os_release_memory.
+void *os_reserve_memory(size_t reserve_size, size_t commit_size, void **reserved_end);
+
+/// makes [p, p + size) of a reservation usable. p and size must be multiples of OS_PAGE_SIZE. Returns 0 on failure.
+int os_commit_memory(void *p, size_t size);
+
+/// returns the pages in [p, p + size) to the OS. They stay usable and are zero-filled on their next use. p and size
+/// must be multiples of OS_PAGE_SIZE and the memory must have been mapped by this module. Returns 0 on failure.
+int os_decommit_memory(void *p, size_t size);
+
+/// resizes memory returned by os_request_memory so that at least min_size bytes are usable, moving the pages (not their
+/// content) to another address if the mapping cannot grow in place. Returns the (possibly moved) memory and writes the
+/// granted size to *granted_size, or returns NULL and leaves the memory untouched if the platform cannot remap memory
+/// or the resize fails.
+void *os_resize_memory(void *p, size_t min_size, size_t *granted_size);
+
+/// release_memory implementation for memory returned by os_request_memory and os_request_huge_page_memory
+void os_release_memory(void *p);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef PAGE_MAP_H
+#define PAGE_MAP_H
+
+#include <stddef.h>
+
+/// marks every page overlapping [p, p + size) as belonging to a memory region of the given meta type. The page map is
+/// process-wide (shared by all allocators), so callers must only ever register pages that exclusively belong to them.
+void page_map_set_range(const void *p, size_t size, unsigned char meta_type);
+
+/// unregisters every page overlapping [p, p + size)
+void page_map_clear_range(const void *p, size_t size);
+
+/// returns the meta type of the region p points into, or 0 if the page p points into is not registered
+unsigned char page_map_get(const void *p);
+
+#endif
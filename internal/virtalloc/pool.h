@@ -0,0 +1,55 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include "virtalloc/allocator.h"
+#include "virtalloc/allocator_settings.h"
+
+/// a POOL_SLAB_SIZE aligned block of POOL_SLAB_SIZE bytes, requested from the parent allocator. The objects follow the
+/// header, so the slab of an object is found by aligning the object's address down to POOL_SLAB_SIZE.
+typedef struct PoolSlab {
+    /// the pool the slab belongs to
+    struct Pool *pool;
+    /// the neighbours in the pool's list of partial or full slabs
+    struct PoolSlab *prev, *next;
+    /// freed objects of the slab, linked through their first word
+    void *free_list;
+    /// where the objects that were never handed out start (objects are carved lazily so new slabs are cheap)
+    void *unused_start;
+    /// the number of objects that are currently allocated
+    size_t num_allocated;
+} PoolSlab;
+
+/// an allocator for objects of one size. Not thread safe.
+typedef struct Pool {
+    /// the allocator the pool and its slabs are allocated from
+    Allocator *allocator;
+    /// the distance between two objects in a slab (the object size aligned to the object alignment)
+    size_t object_stride;
+    /// the offset of the first object from the start of its slab
+    size_t first_object_offset;
+    /// how many objects fit into a slab
+    size_t objects_per_slab;
+    /// slabs with at least one free object. Allocations are made from the head.
+    PoolSlab *partial_slabs;
+    /// slabs without free objects
+    PoolSlab *full_slabs;
+    /// the number of slabs the pool currently holds
+    size_t num_slabs;
+} Pool;
+
+/// creates a pool of objects of object_size bytes aligned to align (a power of 2, or 0 for POOL_DEFAULT_ALIGN).
+/// Returns NULL if the alignment is invalid, an object does not fit into a slab or the pool could not be allocated.
+Pool *pool_create(Allocator *allocator, size_t object_size, size_t align);
+
+/// returns a free object in O(1), or NULL if no new slab could be allocated
+void *pool_alloc(Pool *pool);
+
+/// gives the object p back to the pool in O(1). Slabs are returned to the parent allocator once they are empty, except
+/// for the last slab with free objects, which is kept so alternating alloc/free does not request a slab every time.
+void pool_free(Pool *pool, void *p);
+
+/// frees all slabs and the pool itself
+void pool_destroy(Pool *pool);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef RELOCATION_COPY_H
+#define RELOCATION_COPY_H
+
+#include <stddef.h>
+
+/// copies size bytes from src to dst, which must not overlap. Used when realloc relocates an allocation. Copies of at
+/// least NON_TEMPORAL_COPY_MIN_SIZE bytes use non-temporal stores (AVX2 or SSE2, picked at runtime) so that the copy
+/// does not evict the rest of the cache, smaller ones use memcpy.
+void relocation_copy(void *dst, const void *src, size_t size);
+
+/// copies size bytes from src to dst, which must not overlap, with non-temporal stores (AVX2 or SSE2, picked at
+/// runtime), i.e. without pulling dst into the cache. Falls back to memcpy on other architectures and for copies too
+/// small to contain an aligned block of 128 bytes.
+void non_temporal_copy(void *dst, const void *src, size_t size);
+
+#endif
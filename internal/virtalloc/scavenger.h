@@ -0,0 +1,16 @@
+#ifndef SCAVENGER_H
+#define SCAVENGER_H
+
+#include <stddef.h>
+#include "virtalloc/allocator.h"
+
+/// starts a background thread that, every interval_ms milliseconds, decommits free GPA memory beyond
+/// keep_resident_bytes and requests new memory for the GPA whenever it has less than reserve_bytes of free memory, so
+/// that mallocs rarely have to request memory themselves. Returns 1 on success, 0 if the allocator already has a
+/// scavenger, is not thread safe or the platform does not support scavengers.
+int start_scavenger(Allocator *allocator, unsigned interval_ms, size_t keep_resident_bytes, size_t reserve_bytes);
+
+/// stops the scavenger of the given allocator (if it has one) and waits for its current pass to finish
+void stop_scavenger(Allocator *allocator);
+
+#endif
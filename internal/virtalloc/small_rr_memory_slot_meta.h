@@ -1,6 +1,8 @@
 #ifndef SMALL_RR_MEMORY_SLOT_META_H
 #define SMALL_RR_MEMORY_SLOT_META_H
 
+#include <stddef.h>
+
 typedef struct SmallRRMemorySlotMeta {
     unsigned char is_free: 1;
     unsigned char meta_type: 7;  // 3 for this struct type
@@ -10,8 +12,10 @@ typedef struct SmallRRMemorySlotMeta {
 typedef struct SmallRRStartOfMemoryChunkMeta {
     /// this is actually a void* stored as raw bytes for alignment reasons
     char memory_chunk_ptr_raw_bytes[sizeof(void *)];
+    /// the size of the chunk starting at this meta, stored as raw bytes for alignment reasons
+    char chunk_size_raw_bytes[sizeof(size_t)];
     unsigned char must_release_chunk_on_destroy: 1;
-    char __padding[63 - sizeof(void *) - sizeof(unsigned char)];  // pad this to 63 bytes
+    char __padding[63 - sizeof(void *) - sizeof(size_t) - sizeof(unsigned char)];  // pad this to 63 bytes
 } SmallRRStartOfMemoryChunkMeta;
 
 typedef struct SmallRRNextSlotLink {
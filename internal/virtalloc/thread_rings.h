@@ -0,0 +1,17 @@
+#ifndef THREAD_RINGS_H
+#define THREAD_RINGS_H
+
+#include "virtalloc/allocator.h"
+
+/// returns the calling thread's ring of the given allocator, acquiring an unowned ring on first use. Returns NULL if
+/// every ring is owned by another thread or the platform does not support per-thread rings.
+ThreadRing *get_thread_ring(Allocator *allocator);
+
+/// takes over an abandoned ring that still has memory and splices its chunks into `ring`. Must be called by the owner of
+/// `ring` while holding the allocator lock. Returns 1 if a ring was adopted, 0 otherwise.
+int adopt_abandoned_ring(Allocator *allocator, ThreadRing *ring);
+
+/// makes every thread forget its ring of the given allocator (must be called before the allocator is destroyed)
+void forget_thread_rings_of(const Allocator *allocator);
+
+#endif
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <memory.h>
 #include <stddef.h>
+#include <limits.h>
+#include "virtalloc.h"
 #include "virtalloc/allocator.h"
 #include "virtalloc/gp_memory_slot_meta.h"
 #include "virtalloc/small_rr_memory_slot_meta.h"
@@ -10,6 +12,48 @@
 #include "virtalloc/math_utils.h"
 #include "virtalloc/helper_macros.h"
 #include "virtalloc/check_allocator.h"
+#include "virtalloc/page_map.h"
+#include "virtalloc/exploration_tuner.h"
+#include "virtalloc/thread_rings.h"
+#include "virtalloc/os_memory.h"
+#include "virtalloc/early_release_cache.h"
+#include "virtalloc/relocation_copy.h"
+
+/// the part of an early release block that is registered in the page map (the block exclusively owns these pages)
+static size_t get_early_release_page_map_size(const GPEarlyReleaseMeta *meta) {
+    return align_down((size_t) meta + sizeof(*meta) + meta->size, PAGE_MAP_PAGE_SIZE) - (size_t) meta;
+}
+
+/// adds an early release block to the allocator's list of live early release blocks (the backing lock must be held)
+static void link_early_release_block(Allocator *allocator, GPEarlyReleaseMeta *meta) {
+    meta->prev_block = NULL;
+    meta->next_block = allocator->early_release_blocks;
+    if (meta->next_block) {
+        meta->next_block->prev_block = meta;
+        refresh_checksum_of(allocator, meta->next_block);
+    }
+    refresh_checksum_of(allocator, meta);
+    allocator->early_release_blocks = meta;
+    allocator->num_early_release_blocks++;
+    allocator->early_release_bytes += meta->size;
+}
+
+/// removes an early release block from the allocator's list of live early release blocks (the backing lock must be
+/// held)
+static void unlink_early_release_block(Allocator *allocator, GPEarlyReleaseMeta *meta) {
+    if (meta->prev_block) {
+        meta->prev_block->next_block = meta->next_block;
+        refresh_checksum_of(allocator, meta->prev_block);
+    } else {
+        allocator->early_release_blocks = meta->next_block;
+    }
+    if (meta->next_block) {
+        meta->next_block->prev_block = meta->prev_block;
+        refresh_checksum_of(allocator, meta->next_block);
+    }
+    allocator->num_early_release_blocks--;
+    allocator->early_release_bytes -= meta->size;
+}
 
 /// pad to alignment requirement and add safety padding to prevent off-by-1 bugs on the user end
 static size_t get_gpa_compatible_size(const Allocator *allocator, size_t requested_size) {
@@ -17,7 +61,19 @@ static size_t get_gpa_compatible_size(const Allocator *allocator, size_t request
                           ? allocator->get_gpa_padding_lines(requested_size) * LARGE_ALLOCATION_ALIGN
                           : 0;
     return align_to(requested_size < MIN_LARGE_ALLOCATION_SIZE ? MIN_LARGE_ALLOCATION_SIZE : requested_size,
-                    LARGE_ALLOCATION_ALIGN);
+                    allocator->gpa.alignment);
+}
+
+/// the opposite of get_gpa_compatible_size: the biggest request that gets a data section of at most the given size. The
+/// safety padding is not handed out, so that reallocating to the usable size doesn't grow the slot.
+static size_t get_gpa_usable_size(const Allocator *allocator, const size_t size) {
+    if (!allocator->get_gpa_padding_lines || size < MIN_SIZE_FOR_SAFETY_PADDING)
+        return size;
+    if (size - MIN_SIZE_FOR_SAFETY_PADDING >= LARGE_ALLOCATION_ALIGN)
+        // padded requests fit, and every unpadded one is smaller than them
+        return size - allocator->get_gpa_padding_lines(size - LARGE_ALLOCATION_ALIGN) * LARGE_ALLOCATION_ALIGN;
+    // the slot was rounded up from an unpadded request, and a padded one would not fit
+    return MIN_SIZE_FOR_SAFETY_PADDING - 1;
 }
 
 static void dump_sorted_free_list(FILE *file, const Allocator *allocator) {
@@ -82,6 +138,10 @@ void virtalloc_dump_allocator_to_file_impl(FILE *file, Allocator *allocator) {
     fprintf(file, "First General Purpose Slot: %p\n", allocator->gpa.first_slot);
     fprintf(file, "First Small Slot: %p\n", allocator->sma.first_slot);
     fprintf(file, "Num Buckets: %zu\n", allocator->gpa.num_buckets);
+    fprintf(file, "GPA Slot Check Budget: %zu%s\n", allocator->gpa.max_slot_checks_before_oom,
+            allocator->gpa.tuner.is_enabled ? " (adaptive)" : "");
+    fprintf(file, "SMA Slot Check Budget: %zu%s\n", allocator->sma.max_slot_checks_before_oom,
+            allocator->sma.tuner.is_enabled ? " (adaptive)" : "");
     fprintf(file, "Bucket Strategy: %s\n", allocator->bucket_strategy == BUCKET_ARENAS
                                                ? "Arenas"
                                                : allocator->bucket_strategy == BUCKET_TREE
@@ -161,15 +221,186 @@ void virtalloc_dump_allocator_to_file_impl(FILE *file, Allocator *allocator) {
         }
     }
 
+    if (allocator->early_release_blocks) {
+        fprintf(file, "\nEARLY RELEASE BLOCKS (%zu blocks, %zu bytes):\n", allocator->num_early_release_blocks,
+                allocator->early_release_bytes);
+        i = 1;
+        for (GPEarlyReleaseMeta *er_meta = allocator->early_release_blocks; er_meta; er_meta = er_meta->next_block)
+            dump_early_release_meta_to_file(file, er_meta, i++);
+    }
+
     fprintf(file, "\n===== ////////////////////////// =====\n");
     allocator->block_logging = 0; // re-enable logging (does nothing if the project is not compiled with it)
 }
 
-static int try_add_new_memory(Allocator *allocator, const size_t min_size, const int using_rr_allocator) {
+static void gpa_add_memory(Allocator *allocator, void *p, size_t size, int memory_is_owned, int is_zero_filled);
+
+/// commits at least *size more bytes of the allocator's reservation and writes the committed size to *size. Returns
+/// NULL if the reservation is exhausted.
+static void *commit_reserved_memory(Allocator *allocator, size_t *size) {
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    void *p = allocator->committed_end;
+    const size_t commit_size = align_to(*size, OS_PAGE_SIZE);
+    if (commit_size > (size_t) (allocator->reserved_end - p) || !os_commit_memory(p, commit_size)) {
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        return NULL;
+    }
+    __atomic_store_n(&allocator->committed_end, p + commit_size, __ATOMIC_RELAXED);
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    *size = commit_size;
+    return p;
+}
+
+/// returns the page aligned interior of a free slot's data section to the OS. Returns the number of bytes returned.
+static size_t decommit_free_slot(Allocator *allocator, GPMemorySlotMeta *meta) {
+    if (!allocator->can_decommit || meta->is_decommitted)
+        return 0;
+    void *start = (void *) align_to((size_t) meta->data, OS_PAGE_SIZE);
+    void *end = (void *) align_down((size_t) meta->data + meta->size, OS_PAGE_SIZE);
+    if (end <= start || (size_t) (end - start) < TRIM_MIN_DECOMMIT_SIZE || !os_decommit_memory(start, end - start))
+        return 0;
+    meta->is_decommitted = 1;
+    refresh_checksum_of(allocator, meta);
+    return end - start;
+}
+
+/// if the free slot spans all of its owned region (from the region's start to its end), removes it from the GPA and
+/// releases the region. Returns the number of bytes released.
+static size_t release_free_region(Allocator *allocator, GPMemorySlotMeta *meta) {
+    if (!meta->memory_is_owned || !allocator->release_memory)
+        return 0;
+    GPMemorySlotMeta *next_meta = get_meta(allocator, meta->next, NO_EXPECTATION);
+    if (next_meta != meta && !next_meta->memory_is_owned
+        && next_meta->data - sizeof(*next_meta) == meta->data + meta->size)
+        // the rest of the region is still in use
+        return 0;
+
+    unbind_from_sorted_free_list(allocator, meta);
+    if (meta->next == meta->data) {
+        allocator->gpa.first_slot = NULL;
+    } else {
+        GPMemorySlotMeta *prev_meta = get_meta(allocator, meta->prev, NO_EXPECTATION);
+        prev_meta->next = meta->next;
+        next_meta->prev = meta->prev;
+        refresh_checksum_of(allocator, prev_meta);
+        refresh_checksum_of(allocator, next_meta);
+        if (allocator->gpa.first_slot == meta->data)
+            allocator->gpa.first_slot = meta->next;
+    }
+
+    const size_t size = sizeof(GPMemorySlotMeta) + meta->size;
+    if (allocator->use_page_map)
+        page_map_clear_range(meta, size);
+    // invalidate the checksum to catch use after release more easily
+    meta->checksum = 0;
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    allocator->release_memory((void *) meta - meta->memory_pointer_right_adjustment);
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    return size;
+}
+
+/// returns the memory of a free slot to the OS, either by releasing its whole region (if release_regions is set) or by
+/// decommitting its pages
+static size_t trim_free_slot(Allocator *allocator, GPMemorySlotMeta *meta, const int release_regions) {
+    const size_t released = release_regions ? release_free_region(allocator, meta) : 0;
+    return released ? released : decommit_free_slot(allocator, meta);
+}
+
+size_t virtalloc_trim_impl(Allocator *allocator, const size_t keep_bytes, const int release_regions) {
+    debug_print_enter_fn(allocator->block_logging, "virtalloc_trim_impl");
+    // cached early release blocks are not part of the heap, so they are all released regardless of keep_bytes
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    size_t trimmed = early_release_cache_flush(allocator);
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    if (!allocator->gpa.first_slot) {
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+        debug_print_leave_fn(allocator->block_logging, "virtalloc_trim_impl");
+        return trimmed;
+    }
+
+    // count the slots (trimming may remove slots, so the walk below cannot stop at first_slot) and the free memory
+    // that is still resident
+    size_t num_slots = 0;
+    size_t resident_free_bytes = 0;
+    void *slot = allocator->gpa.first_slot;
+    do {
+        const GPMemorySlotMeta *meta = get_meta(allocator, slot, NO_EXPECTATION);
+        if (meta->is_free && !meta->is_decommitted)
+            resident_free_bytes += meta->size;
+        num_slots++;
+        slot = meta->next;
+    } while (slot != allocator->gpa.first_slot);
+
+    for (size_t i = 0; i < num_slots && resident_free_bytes > keep_bytes; i++) {
+        GPMemorySlotMeta *meta = get_meta(allocator, slot, NO_EXPECTATION);
+        slot = meta->next;
+        if (!meta->is_free || meta->is_decommitted)
+            continue;
+        const size_t slot_size = meta->size;
+        const size_t slot_trimmed = trim_free_slot(allocator, meta, release_regions);
+        if (slot_trimmed) {
+            trimmed += slot_trimmed;
+            resident_free_bytes -= slot_size;
+        }
+    }
+
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    debug_print_leave_fn(allocator->block_logging, "virtalloc_trim_impl");
+    return trimmed;
+}
+
+/// requests new memory and gives it to the GPA, or to the given SMA if sma is non-NULL
+static int try_add_new_memory(Allocator *allocator, size_t min_size, SmallRRAllocator *sma);
+
+/// how much memory to request when the allocator runs out of memory for an allocation of the given size
+static size_t get_new_memory_request_size(const Allocator *allocator, size_t size);
+
+size_t get_gpa_free_bytes(Allocator *allocator) {
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    size_t free_bytes = 0;
+    void *slot = allocator->gpa.first_slot;
+    if (slot) {
+        do {
+            const GPMemorySlotMeta *meta = get_meta(allocator, slot, NO_EXPECTATION);
+            if (meta->is_free)
+                free_bytes += meta->size;
+            slot = meta->next;
+        } while (slot != allocator->gpa.first_slot);
+    }
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    return free_bytes;
+}
+
+int refill_gpa_reserve(Allocator *allocator, const size_t reserve_bytes) {
+    const size_t free_bytes = get_gpa_free_bytes(allocator);
+    if (free_bytes >= reserve_bytes)
+        return 0;
+    // the GPA lock is not held here, so mallocs can continue while the new memory is requested
+    return try_add_new_memory(allocator, get_new_memory_request_size(allocator, reserve_bytes - free_bytes), NULL);
+}
+
+static int try_add_new_memory(Allocator *allocator, const size_t min_size, SmallRRAllocator *sma) {
     debug_print_enter_fn(allocator->block_logging, "try_add_new_memory");
     assert_internal(min_size >= 8 && "unreachable");
-    if (!using_rr_allocator && allocator->gpa_add_new_memory && allocator->request_new_memory) {
+    if (allocator->reserved_end && (!sma || !allocator->sma_request_mem_from_gpa)) {
+        // the committed memory directly follows the heap, so for the GPA, it simply extends the last slot if that is
+        // free. Committed memory is part of the reservation and thus never released on its own (not owned). There is
+        // no fallback if the reservation is exhausted, so that all slots are guaranteed to lie in the reservation.
+        size_t size = min_size;
+        void *mem = commit_reserved_memory(allocator, &size);
+        if (mem && sma)
+            allocator->sma_add_new_memory(allocator, sma, mem, size, 0);
+        else if (mem)
+            gpa_add_memory(allocator, mem, size, 0, 1);
+        debug_print_leave_fn(allocator->block_logging, "try_add_new_memory");
+        return mem != NULL;
+    }
+    if (!sma && allocator->gpa_add_new_memory && allocator->request_new_memory) {
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
         void *mem = allocator->request_new_memory(min_size);
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
         if (!mem) {
             debug_print_leave_fn(allocator->block_logging, "try_add_new_memory");
             return 0;
@@ -179,13 +410,17 @@ static int try_add_new_memory(Allocator *allocator, const size_t min_size, const
         debug_print_leave_fn(allocator->block_logging, "try_add_new_memory");
         return 1;
     }
-    if (using_rr_allocator && allocator->sma_add_new_memory && (
+    if (sma && allocator->sma_add_new_memory && (
             allocator->request_new_memory || allocator->sma_request_mem_from_gpa)) {
         void *mem;
-        if (allocator->sma_request_mem_from_gpa)
+        if (allocator->sma_request_mem_from_gpa) {
+            // only holds the GPA lock while the chunk is carved out of the GPA
             mem = virtalloc_malloc_impl(allocator, max(min_size, MAX_TINY_ALLOCATION_SIZE), 0);
-        else
+        } else {
+            allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
             mem = allocator->request_new_memory(min_size);
+            allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        }
 
         if (!mem) {
             debug_print_leave_fn(allocator->block_logging, "try_add_new_memory");
@@ -194,7 +429,7 @@ static int try_add_new_memory(Allocator *allocator, const size_t min_size, const
         const size_t size = allocator->sma_request_mem_from_gpa
                                 ? max(min_size, MAX_TINY_ALLOCATION_SIZE)
                                 : *(size_t *) mem; // request_new_memory writes buffer capacity to first 8 buf bytes
-        allocator->sma_add_new_memory(allocator, mem, size, !allocator->sma_request_mem_from_gpa);
+        allocator->sma_add_new_memory(allocator, sma, mem, size, !allocator->sma_request_mem_from_gpa);
         debug_print_leave_fn(allocator->block_logging, "try_add_new_memory");
         return 1;
     }
@@ -202,63 +437,184 @@ static int try_add_new_memory(Allocator *allocator, const size_t min_size, const
     return 0;
 }
 
+/// how much memory to request when the allocator runs out of memory for an allocation of the given size
+static size_t get_new_memory_request_size(const Allocator *allocator, const size_t size) {
+    return max(size, max(allocator->bucket_strategy == BUCKET_ARENAS ? allocator->gpa.bucket_sizes[allocator->gpa.
+                   num_buckets - 1] : 0, MIN_NEW_MEM_REQUEST_SIZE)) + sizeof(GPMemorySlotMeta) + LARGE_ALLOCATION_ALIGN
+           - 1 + (allocator->use_page_map ? 2 * PAGE_MAP_PAGE_SIZE : 0);
+}
+
+/// feeds the outcome of a slot search to the exploration tuner of the given SMA, or of the GPA if sma is NULL. Retry
+/// runs are not recorded because the outcome of the search that triggered the retry has been recorded already.
+static void record_exploration(Allocator *allocator, SmallRRAllocator *sma, const size_t probes, const size_t misses,
+                               const int hit, const int is_retry_run) {
+    if (is_retry_run)
+        return;
+    if (sma)
+        exploration_tuner_record(&sma->tuner, &sma->max_slot_checks_before_oom, probes, misses, hit);
+    else
+        exploration_tuner_record(&allocator->gpa.tuner, &allocator->gpa.max_slot_checks_before_oom, probes, misses,
+                                 hit);
+}
+
+/// searches the ring of the given SMA for a free slot, starting after its rr_slot, and marks it as allocated. Returns
+/// NULL if no free slot was found within the exploration budget (the SMA must grow then). The caller must either hold
+/// the SMA lock or own the ring.
+static void *sma_take_free_slot(Allocator *allocator, SmallRRAllocator *sma, const int is_retry_run) {
+    void *rr_slot = sma->rr_slot;
+    if (!rr_slot) {
+        record_exploration(allocator, sma, 0, 0, 0, is_retry_run);
+        return NULL;
+    }
+    const void *starting_rr_slot = sma->rr_slot;
+    int is_first_iter = 1;
+    size_t ic = 0;
+    size_t budget = sma->max_slot_checks_before_oom;
+explore:
+    while (((rr_slot = get_next_rr_slot(allocator, rr_slot)) != starting_rr_slot && ic < budget) || is_first_iter) {
+        is_first_iter = 0;
+        const SmallRRMemorySlotMeta meta = load_rr_slot_meta(rr_slot - sizeof(SmallRRMemorySlotMeta));
+        if (meta.meta_type == RR_META_TYPE_LINK) {
+            rr_slot = get_next_rr_slot(allocator, rr_slot);
+            continue;
+        }
+        if (meta.is_free)
+            break;
+        ic++;
+    }
+    SmallRRMemorySlotMeta *meta_ptr = rr_slot - sizeof(SmallRRMemorySlotMeta);
+    const SmallRRMemorySlotMeta meta = load_rr_slot_meta(meta_ptr);
+    if (meta.meta_type == RR_META_TYPE_SLOT && meta.is_free) {
+        set_rr_slot_is_free(meta_ptr, 0);
+        sma->rr_slot = rr_slot;
+        record_exploration(allocator, sma, ic + 1, ic, 1, is_retry_run);
+        return rr_slot;
+    }
+    if (rr_slot != starting_rr_slot && !exploration_tuner_should_grow(&sma->tuner, ic)) {
+        // ran out of budget, but most slots are estimated to be free, so this was likely just a cluster of
+        // allocated slots -> keep exploring instead of growing the SMA
+        budget = sma->tuner.max_budget;
+        goto explore;
+    }
+    record_exploration(allocator, sma, ic, ic, 0, is_retry_run);
+    return NULL;
+}
+
+/// allocates a small slot from the calling thread's own ring. Only growing the ring requires the SMA lock.
+static void *thread_ring_malloc(Allocator *allocator, ThreadRing *ring) {
+    void *slot = sma_take_free_slot(allocator, &ring->sma, 0);
+    if (slot)
+        return slot;
+
+    // the ring is full: adopt the memory of a ring abandoned by an exited thread or grow the ring
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_SMA);
+    const int got_memory = adopt_abandoned_ring(allocator, ring)
+                           || try_add_new_memory(allocator, get_new_memory_request_size(allocator, 0), &ring->sma);
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_SMA);
+    return got_memory ? sma_take_free_slot(allocator, &ring->sma, 1) : NULL;
+}
+
+/// allocates a slot of the given (GPA compatible) size from the GPA, requesting new memory if none is big enough
+static void *gpa_malloc(Allocator *allocator, size_t size, int is_retry_run);
+
+/// allocates the given (GPA compatible) size as a separate early release block whose data is aligned to alignment.
+/// This does not touch the GPA at all, so only the backing lock is taken (for request_new_memory and the list of live
+/// early release blocks).
+static void *malloc_early_release_block(Allocator *allocator, size_t size, const size_t alignment) {
+    // rounding to a size class leaves room for growth, which makes realloc much more efficient
+    size = round_to_size_class(size, EARLY_RELEASE_SIZE_CLASSES_PER_DOUBLING);
+    // the meta is moved to the next alignment boundary (or, with the page map, to the next page boundary so the block
+    // exclusively owns its first page) because request_new_memory makes no alignment guarantees. For stricter
+    // alignments, the meta is moved further so that the data behind it is aligned.
+    const size_t meta_align = allocator->use_page_map ? PAGE_MAP_PAGE_SIZE : LARGE_ALLOCATION_ALIGN;
+    const size_t alignment_slack = meta_align + alignment - LARGE_ALLOCATION_ALIGN;
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    // cached blocks only guarantee the default alignment
+    GPEarlyReleaseMeta *cached_meta = alignment == LARGE_ALLOCATION_ALIGN
+                                          ? early_release_cache_take(allocator, size)
+                                          : NULL;
+    if (cached_meta) {
+        // a recently freed block of the same size class is reused as is, its meta is still intact
+        link_early_release_block(allocator, cached_meta);
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        if (allocator->use_page_map)
+            page_map_set_range(cached_meta, get_early_release_page_map_size(cached_meta),
+                               GP_META_TYPE_EARLY_RELEASE_SLOT);
+        return cached_meta + 1;
+    }
+    void *mem = allocator->request_new_memory(sizeof(GPEarlyReleaseMeta) + size + alignment_slack);
+    if (!mem) {
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        return NULL;
+    }
+    const size_t granted_size = *(size_t *) mem;
+    assert_external(granted_size >= sizeof(GPEarlyReleaseMeta) + size + alignment_slack);
+    void *meta_ptr = (void *) align_to(align_to((size_t) mem, meta_align) + sizeof(GPEarlyReleaseMeta), alignment)
+                     - sizeof(GPEarlyReleaseMeta);
+    // memory from the OS backend (see can_decommit) is freshly mapped, so calloc doesn't have to zero it
+    GPEarlyReleaseMeta meta_content = {
+        .time_to_checksum_check = 0, .checksum = 0, .data = mem,
+        .size = mem + granted_size - meta_ptr - sizeof(GPEarlyReleaseMeta), .prev_block = NULL,
+        .next_block = NULL, .is_zero_filled = allocator->can_decommit, .__bit_padding1 = 0,
+        .__padding = {0}, .__bit_padding2 = 0, .meta_type = GP_META_TYPE_EARLY_RELEASE_SLOT
+    };
+    *(GPEarlyReleaseMeta *) meta_ptr = meta_content;
+    link_early_release_block(allocator, meta_ptr);
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    if (allocator->use_page_map)
+        page_map_set_range(meta_ptr, get_early_release_page_map_size(meta_ptr), GP_META_TYPE_EARLY_RELEASE_SLOT);
+    return meta_ptr + sizeof(GPEarlyReleaseMeta);
+}
+
 void *virtalloc_malloc_impl(Allocator *allocator, size_t size, const int is_retry_run) {
     check_allocator(allocator);
     debug_print_enter_fn(allocator->block_logging, "virtalloc_malloc_impl");
-    allocator->pre_alloc_op(allocator);
 
-    int using_rr_allocator = 0;
-    if (!allocator->no_rr_allocator && size < MAX_TINY_ALLOCATION_SIZE - sizeof(SmallRRMemorySlotMeta)) {
-        // use the small round-robin allocator
-        using_rr_allocator = 1;
-        void *rr_slot = allocator->sma.rr_slot;
-        if (!rr_slot)
-            goto oom;
-        const void *starting_rr_slot = allocator->sma.rr_slot;
-        int is_first_iter = 1;
-        size_t ic = 0;
-        while (((rr_slot = get_next_rr_slot(allocator, rr_slot)) != starting_rr_slot && ic < allocator->sma.
-                max_slot_checks_before_oom) || is_first_iter) {
-            is_first_iter = 0;
-            const SmallRRMemorySlotMeta *meta = rr_slot - sizeof(SmallRRMemorySlotMeta);
-            if (meta->meta_type == RR_META_TYPE_LINK) {
-                rr_slot = get_next_rr_slot(allocator, rr_slot);
-                continue;
-            }
-            if (meta->is_free)
-                break;
-            ic++;
+    const int is_small = !allocator->no_rr_allocator && size < MAX_TINY_ALLOCATION_SIZE - sizeof(
+                             SmallRRMemorySlotMeta);
+    if (is_small && allocator->per_thread_sma) {
+        ThreadRing *ring = get_thread_ring(allocator);
+        if (ring) {
+            void *slot = thread_ring_malloc(allocator, ring);
+            debug_print_leave_fn(allocator->block_logging, "virtalloc_malloc_impl");
+            return slot;
         }
-        SmallRRMemorySlotMeta *meta = rr_slot - sizeof(SmallRRMemorySlotMeta);
-        if (meta->meta_type == RR_META_TYPE_SLOT && meta->is_free) {
-            meta->is_free = 0;
-            allocator->sma.rr_slot = rr_slot;
-            allocator->post_alloc_op(allocator);
-            return rr_slot;
-        }
-        goto oom;
+        // every ring is owned by another thread, fall back to the shared SMA
+    }
+
+    if (is_small) {
+        // use the small round-robin allocator
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_SMA);
+        void *rr_slot = sma_take_free_slot(allocator, &allocator->sma, is_retry_run);
+        if (!rr_slot && !is_retry_run
+            && try_add_new_memory(allocator, get_new_memory_request_size(allocator, size), &allocator->sma))
+            // retry with the new memory (can only retry once)
+            rr_slot = sma_take_free_slot(allocator, &allocator->sma, 1);
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_SMA);
+        debug_print_leave_fn(allocator->block_logging, "virtalloc_malloc_impl");
+        return rr_slot;
     }
 
     // pad to alignment requirement and add safety padding to prevent off-by-1 bugs on the user end
     size = is_retry_run ? size : get_gpa_compatible_size(allocator, size);
 
     // check if the size exceeds a certain limit and if it does, use early release mechanism for the allocation
-    if (size >= allocator->gpa.min_size_for_early_release && allocator->request_new_memory) {
-        size = round_to_power_of_2(size); // should make realloc much more efficient
-        void *mem = allocator->request_new_memory(sizeof(GPEarlyReleaseMeta) + size);
-        if (!mem)
-            return NULL;
-        const size_t granted_size = *(size_t *) mem;
-        assert_external(granted_size >= sizeof(GPEarlyReleaseMeta) + size);
-        GPEarlyReleaseMeta meta_content = {
-            .time_to_checksum_check = 0, .checksum = 0, .data = mem, .size = granted_size - sizeof(GPEarlyReleaseMeta),
-            .__padding = 0, .__bit_padding2 = 0, .meta_type = GP_META_TYPE_EARLY_RELEASE_SLOT
-        };
-        refresh_checksum_of(allocator, &meta_content);
-        *(GPEarlyReleaseMeta *) mem = meta_content;
-        return mem + sizeof(GPEarlyReleaseMeta);
+    if (size >= __atomic_load_n(&allocator->gpa.min_size_for_early_release, __ATOMIC_RELAXED)
+        && allocator->request_new_memory) {
+        void *block = malloc_early_release_block(allocator, size, LARGE_ALLOCATION_ALIGN);
+        debug_print_leave_fn(allocator->block_logging, "virtalloc_malloc_impl");
+        return block;
     }
 
+    void *slot = gpa_malloc(allocator, size, is_retry_run);
+    debug_print_leave_fn(allocator->block_logging, "virtalloc_malloc_impl");
+    return slot;
+}
+
+static void *gpa_malloc(Allocator *allocator, const size_t size, const int is_retry_run) {
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    size_t probes = 0;
+
     // find the bucket that fits the size (the largest bucket that is still smaller)
     const size_t bucket_idx = get_bucket_index(allocator, size);
     void *attempted_slot = get_bucket_entry(allocator, bucket_idx);
@@ -283,16 +639,22 @@ void *virtalloc_malloc_impl(Allocator *allocator, size_t size, const int is_retr
     }
 
     // try to find the smallest free slot to consume that still fits through forwards exploration (best-fit strategy)
-    int is_first_iter = 1;
-    const void *starting_slot = meta->data;
-    size_t ic = 0;
+    void *const bucket_slot = attempted_slot;
+    size_t budget = allocator->gpa.max_slot_checks_before_oom;
+    int is_first_iter;
+    const void *starting_slot;
+    size_t ic;
+gpa_explore:
+    is_first_iter = 1;
+    starting_slot = meta->data;
+    ic = 0;
     while (meta->size < size
-           && ((meta->data != starting_slot && meta->data != smallest_slot && ic < allocator->gpa.
-                max_slot_checks_before_oom) || is_first_iter)) {
+           && ((meta->data != starting_slot && meta->data != smallest_slot && ic < budget) || is_first_iter)) {
         ic++;
         is_first_iter = 0;
         meta = get_meta(allocator, meta->next_bigger_free, EXPECT_IS_FREE);
     }
+    probes += ic + 1;
     if (meta->size >= size)
         // no slot that is big enough was found
         goto found;
@@ -325,12 +687,12 @@ void *virtalloc_malloc_impl(Allocator *allocator, size_t size, const int is_retr
             starting_slot = meta->data;
             ic = 0;
             while (meta->size > size
-                   && ((meta->data != starting_slot && meta->data != biggest_slot && ic < allocator->gpa.
-                        max_slot_checks_before_oom) || is_first_iter)) {
+                   && ((meta->data != starting_slot && meta->data != biggest_slot && ic < budget) || is_first_iter)) {
                 ic++;
                 is_first_iter = 0;
                 meta = get_meta(allocator, meta->next_smaller_free, EXPECT_IS_FREE);
             }
+            probes += ic + 1;
             if (meta->size < size)
                 // meta currently refers to the next smaller one after the last match -> advance back to the last match
                 meta = get_meta(allocator, meta->next_bigger_free, EXPECT_IS_FREE);
@@ -342,11 +704,18 @@ void *virtalloc_malloc_impl(Allocator *allocator, size_t size, const int is_retr
         }
     }
 
-    // no slot that is big enough was found
+    // no slot that is big enough was found within the budget
+    if (budget < allocator->gpa.tuner.max_budget && !exploration_tuner_should_grow(&allocator->gpa.tuner, probes)) {
+        // most probed slots are usually big enough, so keep exploring instead of growing the GPA
+        budget = allocator->gpa.tuner.max_budget;
+        meta = get_meta(allocator, bucket_slot, EXPECT_IS_FREE);
+        goto gpa_explore;
+    }
     goto oom;
 
 found:
     assert_internal(meta && meta->size >= size && "unreachable");
+    record_exploration(allocator, NULL, probes, probes - 1, 1, is_retry_run);
 
     const size_t remaining_bytes = meta->size - size;
     if (remaining_bytes < sizeof(GPMemorySlotMeta) + MIN_LARGE_ALLOCATION_SIZE) {
@@ -368,7 +737,8 @@ found:
             .checksum = 0, .size = remaining_bytes - sizeof(GPMemorySlotMeta), .data = new_slot_data,
             .next = meta->next, .prev = meta->data, .next_bigger_free = NULL, .next_smaller_free = NULL,
             .time_to_checksum_check = 0, .memory_pointer_right_adjustment = 0, .is_free = 1, .memory_is_owned = 0,
-            .__bit_padding1 = 0, .__padding = {0}, .__bit_padding2 = 0, .meta_type = GP_META_TYPE_SLOT
+            .is_decommitted = meta->is_decommitted, .__bit_padding1 = 0, .growth_streak = 0, .unrequested_size = 0,
+            .__padding = {0}, .__bit_padding2 = 0, .meta_type = GP_META_TYPE_SLOT
         };
 
         // insert slot into normal linked list
@@ -384,77 +754,353 @@ found:
     }
 
     // success
-    allocator->post_alloc_op(allocator);
-    debug_print_leave_fn(allocator->block_logging, "virtalloc_malloc_impl");
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
     return meta->data;
 
 oom:
+    record_exploration(allocator, NULL, probes, probes, 0, is_retry_run);
     // out of memory (try to request more)
-    if (!is_retry_run && try_add_new_memory(
-            allocator,
-            max(size, max(allocator->bucket_strategy == BUCKET_ARENAS ? allocator->gpa.bucket_sizes[allocator->gpa.
-                    num_buckets - 1] : 0, MIN_NEW_MEM_REQUEST_SIZE)) + sizeof(GPMemorySlotMeta) + LARGE_ALLOCATION_ALIGN
-            - 1, using_rr_allocator)) {
+    if (!is_retry_run && try_add_new_memory(allocator, get_new_memory_request_size(allocator, size), NULL)) {
         // retry by requesting new memory and re-running (can only retry once)
-        void *mem = virtalloc_malloc_impl(allocator, size, 1);
-        allocator->post_alloc_op(allocator);
-        debug_print_leave_fn(allocator->block_logging, "virtalloc_malloc_impl");
+        void *mem = gpa_malloc(allocator, size, 1);
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
         return mem;
     }
 
     // failure
-    allocator->post_alloc_op(allocator);
-    debug_print_leave_fn(allocator->block_logging, "virtalloc_malloc_impl");
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
     return NULL;
 }
 
-void virtalloc_free_impl(Allocator *allocator, void *p) {
-    check_allocator(allocator);
-    assert_external(p && "Illegal argument: p (pointer) parameter in virtalloc_free call must be non-null");
-    debug_print_enter_fn(allocator->block_logging, "virtalloc_free_impl");
-    allocator->pre_alloc_op(allocator);
+/// frees a small slot by atomically setting its free bit, which is safe without holding the lock
+static void free_rr_slot(void *p) {
+    SmallRRMemorySlotMeta *meta = p - sizeof(SmallRRMemorySlotMeta);
+    assert_external(!load_rr_slot_meta(meta).is_free && "attempted to free an already free slot (double free)");
+    set_rr_slot_is_free(meta, 1);
+}
+
+/// raises the early release threshold above the size of a freed early release block (if it stays within its bounds),
+/// so that the same size is served from the GPA from now on instead of being requested and released every time
+static void raise_early_release_threshold(Allocator *allocator, const size_t block_size) {
+    if (block_size >= __atomic_load_n(&allocator->gpa.max_dynamic_early_release_size, __ATOMIC_RELAXED))
+        return;
+    size_t threshold = __atomic_load_n(&allocator->gpa.min_size_for_early_release, __ATOMIC_RELAXED);
+    while (block_size >= threshold && !__atomic_compare_exchange_n(&allocator->gpa.min_size_for_early_release,
+                                                                   &threshold, block_size + 1, 1, __ATOMIC_RELAXED,
+                                                                   __ATOMIC_RELAXED)) {
+    }
+}
 
-    const GenericMemorySlotMeta *gm = p - sizeof(GenericMemorySlotMeta);
-    if (gm->meta_type == GP_META_TYPE_SLOT) {
+/// frees p, which is an allocation of the given meta type. If size is non-zero, it is the size the caller allocated and
+/// is checked against the allocation. If trusted is set, the forced checksum validation is skipped.
+static void free_with_meta_type(Allocator *allocator, void *p, const unsigned char meta_type, const size_t size,
+                                const int trusted) {
+    const int check_size = size && !trusted && allocator->enable_safety_checks;
+    if (meta_type == GP_META_TYPE_SLOT) {
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
         GPMemorySlotMeta *meta = get_meta(allocator, p, EXPECT_IS_ALLOCATED);
-        validate_checksum_of(allocator, meta, 1); // force validate the checksum (makes sense here)
+        if (!trusted)
+            validate_checksum_of(allocator, meta, 1); // force validate the checksum (makes sense here)
+        assert_external(!(check_size && size > meta->size) && "size passed to free_sized exceeds the allocation");
         meta->is_free = 1;
+        // the user may have written to the pages, so they are not known to be zero-filled anymore
+        meta->is_decommitted = 0;
+        meta->growth_streak = 0;
+        meta->unrequested_size = 0;
         refresh_checksum_of(allocator, meta);
-        coalesce_memory_slots(allocator, meta, 0);
+        meta = coalesce_memory_slots(allocator, meta, 0);
         refresh_checksum_of(allocator, meta);
-    } else if (gm->meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT) {
+        if (allocator->auto_trim && meta->size >= AUTO_TRIM_MIN_SLOT_SIZE)
+            trim_free_slot(allocator, meta, 1);
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    } else if (meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT) {
+        // early release blocks are not part of the GPA, so only the backing lock is needed (it protects the release
+        // callback and the list of live early release blocks, which modifies the metas of neighbouring blocks)
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
         GPEarlyReleaseMeta *meta = get_early_rel_meta(allocator, p);
-        validate_checksum_of(allocator, meta, 1);
-        assert_internal(meta->data == p && "unreachable");
-        allocator->release_memory(p);
-    } else if (gm->meta_type == RR_META_TYPE_SLOT) {
-        SmallRRMemorySlotMeta *meta = p - sizeof(SmallRRMemorySlotMeta);
-        assert_external(!meta->is_free && "attempted to free an already free slot (double free)");
-        meta->is_free = 1;
+        if (!trusted)
+            validate_checksum_of(allocator, meta, 1);
+        assert_external(!(check_size && size > meta->size) && "size passed to free_sized exceeds the allocation");
+        raise_early_release_threshold(allocator, meta->size);
+        unlink_early_release_block(allocator, meta);
+        // the user may have written to the block, so a cached block is not known to be zero-filled anymore
+        meta->is_zero_filled = 0;
+        refresh_checksum_of(allocator, meta);
+        if (allocator->use_page_map)
+            page_map_clear_range(meta, get_early_release_page_map_size(meta));
+        // meta->data points to the start of the block as it was handed out by request_new_memory
+        if (!early_release_cache_put(allocator, meta))
+            allocator->release_memory(meta->data);
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    } else if (meta_type == RR_META_TYPE_SLOT) {
+        assert_external(
+            !(check_size && size > MAX_TINY_ALLOCATION_SIZE - sizeof(SmallRRMemorySlotMeta)) &&
+            "size passed to free_sized exceeds the allocation");
+        // small slots may belong to another thread's ring, which is fine because freeing them needs no lock
+        free_rr_slot(p);
     } else {
         assert_external(0 && "invalid pointer passed to free: not associated with any allocation");
     }
+}
+
+void virtalloc_free_impl(Allocator *allocator, void *p) {
+    check_allocator(allocator);
+    assert_external(p && "Illegal argument: p (pointer) parameter in virtalloc_free call must be non-null");
+    debug_print_enter_fn(allocator->block_logging, "virtalloc_free_impl");
+
+    const unsigned char meta_type = get_meta_type(allocator, p);
+    assert_external(
+        (meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT || is_in_reserved_heap(allocator, p)) &&
+        "invalid pointer passed to free: not associated with any allocation");
+    free_with_meta_type(allocator, p, meta_type, 0, allocator->trusted_free);
 
-    allocator->post_alloc_op(allocator);
     debug_print_leave_fn(allocator->block_logging, "virtalloc_free_impl");
 }
 
+void virtalloc_free_sized_impl(Allocator *allocator, void *p, const size_t size, int trusted) {
+    check_allocator(allocator);
+    assert_external(p && "Illegal argument: p (pointer) parameter in virtalloc_free_sized call must be non-null");
+    debug_print_enter_fn(allocator->block_logging, "virtalloc_free_sized_impl");
+    trusted |= allocator->trusted_free;
+
+    // allocations of this size never come from the SMA, so a GPA or early release meta directly precedes p and its type
+    // is read from that meta, which saves the page map lookup. An untrusted pointer is still checked below and by the
+    // forced checksum validation in free_with_meta_type.
+    const int may_be_small = !allocator->no_rr_allocator && size < MAX_TINY_ALLOCATION_SIZE - sizeof(
+                                 SmallRRMemorySlotMeta);
+    const unsigned char meta_type = may_be_small
+                                        ? get_meta_type(allocator, p)
+                                        : ((GenericGPMeta *) (p - sizeof(GenericGPMeta)))->meta_type;
+    assert_external(
+        (trusted || meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT || is_in_reserved_heap(allocator, p)) &&
+        "invalid pointer passed to free: not associated with any allocation");
+    free_with_meta_type(allocator, p, meta_type, size, trusted);
+
+    debug_print_leave_fn(allocator->block_logging, "virtalloc_free_sized_impl");
+}
+
+void *virtalloc_calloc_impl(Allocator *allocator, const size_t n, const size_t size) {
+    size_t total_size;
+    if (__builtin_mul_overflow(n, size, &total_size))
+        return NULL;
+    void *p = virtalloc_malloc_impl(allocator, total_size, 0);
+    if (!p)
+        return NULL;
+
+    // [zero_start, zero_end) is the part of the allocation that is known to be zero-filled already. The bits are
+    // cleared so that the memory is not considered zero-filled anymore once the user has written to it.
+    void *zero_start = p;
+    void *zero_end = p;
+    const unsigned char meta_type = get_meta_type(allocator, p);
+    if (meta_type == GP_META_TYPE_SLOT) {
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
+        GPMemorySlotMeta *meta = get_meta(allocator, p, EXPECT_IS_ALLOCATED);
+        if (meta->is_decommitted) {
+            zero_start = (void *) align_to((size_t) p, OS_PAGE_SIZE);
+            zero_end = (void *) align_down((size_t) p + meta->size, OS_PAGE_SIZE);
+            meta->is_decommitted = 0;
+            refresh_checksum_of(allocator, meta);
+        }
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    } else if (meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT) {
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        GPEarlyReleaseMeta *meta = get_early_rel_meta(allocator, p);
+        if (meta->is_zero_filled) {
+            zero_end = p + meta->size;
+            meta->is_zero_filled = 0;
+            refresh_checksum_of(allocator, meta);
+        }
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    }
+
+    if (zero_end <= zero_start) {
+        memset(p, 0, total_size);
+    } else {
+        memset(p, 0, min(total_size, (size_t) (zero_start - p)));
+        if (p + total_size > zero_end)
+            memset(zero_end, 0, p + total_size - zero_end);
+    }
+    return p;
+}
+
+/// resizes an early release block by remapping its pages, which avoids copying its content. Only possible if the block
+/// was mapped by the built-in OS backend. Returns the (possibly moved) data pointer or NULL if the block was left as is.
+/// The backing lock must be held.
+static void *remap_early_release_block(Allocator *allocator, GPEarlyReleaseMeta *meta, const size_t size) {
+    if (allocator->request_new_memory != os_request_memory || allocator->release_memory != os_release_memory)
+        return NULL;
+    // the meta keeps its offset into the mapping, which preserves its alignment because mappings are page aligned
+    const size_t meta_offset = (void *) meta - meta->data;
+    if (allocator->use_page_map)
+        page_map_clear_range(meta, get_early_release_page_map_size(meta));
+    // the neighbours in the list of live blocks must not point to the old meta if the block moves
+    unlink_early_release_block(allocator, meta);
+    size_t granted_size;
+    void *mem = os_resize_memory(meta->data, meta_offset + sizeof(GPEarlyReleaseMeta) + size, &granted_size);
+    if (mem) {
+        meta = mem + meta_offset;
+        meta->data = mem;
+        meta->size = granted_size - meta_offset - sizeof(GPEarlyReleaseMeta);
+        meta->is_zero_filled = 0;
+    }
+    link_early_release_block(allocator, meta);
+    if (allocator->use_page_map)
+        page_map_set_range(meta, get_early_release_page_map_size(meta), GP_META_TYPE_EARLY_RELEASE_SLOT);
+    return mem ? meta + 1 : NULL;
+}
+
+/// shrinks an allocated GPA slot to size by giving its tail to the free neighbour or by splitting it off as a new free
+/// slot. Returns 0 if the slot was left as is because the tail would be too small for a slot of its own.
+static int shrink_gpa_slot(Allocator *allocator, GPMemorySlotMeta *meta, const size_t size) {
+    GPMemorySlotMeta *next_meta = get_meta(allocator, meta->next, NO_EXPECTATION);
+    const size_t shaved_off = meta->size - size;
+    if (next_meta->is_free && !next_meta->memory_is_owned
+        && next_meta->data - sizeof(*next_meta) == meta->data + meta->size) {
+        // merge it into the next slot because it is a free, contiguous neighbour slot (of the same region)
+        consume_prev_slot(allocator, next_meta, shaved_off);
+        return 1;
+    }
+    if (shaved_off < sizeof(GPMemorySlotMeta) + MIN_LARGE_ALLOCATION_SIZE)
+        return 0;
+    // create a new free slot
+    meta->size = size;
+    void *new_slot_data = meta->data + size + sizeof(GPMemorySlotMeta);
+    const GPMemorySlotMeta new_slot_meta_content = {
+        .checksum = 0, .size = shaved_off - sizeof(GPMemorySlotMeta), .data = new_slot_data, .next = meta->next,
+        .prev = meta->data, .next_bigger_free = NULL, .next_smaller_free = NULL, .time_to_checksum_check = 0,
+        .memory_pointer_right_adjustment = 0, .is_free = 1, .memory_is_owned = 0, .is_decommitted = 0,
+        .__bit_padding1 = 0, .growth_streak = 0, .unrequested_size = 0, .__padding = {0}, .__bit_padding2 = 0,
+        .meta_type = GP_META_TYPE_SLOT
+    };
+    GPMemorySlotMeta *new_slot_meta_ptr = new_slot_data - sizeof(GPMemorySlotMeta);
+    *new_slot_meta_ptr = new_slot_meta_content;
+
+    // insert slot into normal linked list
+    meta->next = new_slot_data;
+    next_meta->prev = new_slot_data;
+
+    refresh_checksum_of(allocator, meta);
+    refresh_checksum_of(allocator, next_meta);
+    // redundant because insert_into_sorted_free_list does this anyway
+    // refresh_checksum_of(allocator, new_slot_meta_ptr);
+
+    insert_into_sorted_free_list(allocator, new_slot_meta_ptr);
+    return 1;
+}
+
+/// like shrink_gpa_slot, but like free, it returns the pages of a huge free tail to the OS right away. The tail is not
+/// released because it is part of a region that is still in use.
+static void shrink_and_trim_gpa_slot(Allocator *allocator, GPMemorySlotMeta *meta, const size_t size) {
+    if (!shrink_gpa_slot(allocator, meta, size))
+        return;
+    GPMemorySlotMeta *tail_meta = get_meta(allocator, meta->next, EXPECT_IS_FREE);
+    if (allocator->auto_trim && tail_meta->size >= AUTO_TRIM_MIN_SLOT_SIZE)
+        trim_free_slot(allocator, tail_meta, 0);
+}
+
+/// returns the size the last realloc of the allocated slot meta asked for (see GPMemorySlotMeta.unrequested_size)
+static size_t get_gpa_slot_requested_size(const GPMemorySlotMeta *meta) {
+    return meta->size - (size_t) meta->unrequested_size * MIN_GPA_ALIGN;
+}
+
+/// records that the allocated slot meta was resized to size, which may be less than its actual size. If too much of it
+/// is unrequested to record it, the requested size is overestimated, which means a later realloc shrinks the slot.
+static void set_gpa_slot_requested_size(GPMemorySlotMeta *meta, const size_t size) {
+    meta->unrequested_size = min(meta->size - size, (size_t) USHRT_MAX * MIN_GPA_ALIGN) / MIN_GPA_ALIGN;
+}
+
+/// returns how many bytes of headroom realloc should reserve when growing an allocation from requested_size to size.
+/// Allocations that grew often enough in a row are predicted to keep growing by the same factor, and the headroom is
+/// sized for their next two growths, so only every third growth has to relocate them.
+static size_t predict_growth_headroom(Allocator *allocator, const size_t requested_size, const size_t size,
+                                      const unsigned char growth_streak) {
+    if (growth_streak < REALLOC_GROWTH_STREAK_FOR_HEADROOM)
+        return 0;
+    // the safety padding doesn't grow with the allocation, so it would distort the growth factor
+    const double usable_size = (double) get_gpa_usable_size(allocator, size);
+    const double factor = usable_size / (double) get_gpa_usable_size(allocator, requested_size);
+    const double predicted_growth = usable_size * (factor * factor - 1.0);
+    const size_t headroom = predicted_growth < REALLOC_MAX_HEADROOM
+                                ? align_to((size_t) predicted_growth, allocator->gpa.alignment)
+                                : REALLOC_MAX_HEADROOM;
+    // the headroom must not turn the allocation into an early release block
+    return size + headroom < __atomic_load_n(&allocator->gpa.min_size_for_early_release, __ATOMIC_RELAXED)
+               ? headroom
+               : 0;
+}
+
+/// returns whether the allocated slot meta can grow to size by consuming (part of) its free successor
+static int can_grow_gpa_slot_forwards(Allocator *allocator, const GPMemorySlotMeta *meta, const size_t size) {
+    const GPMemorySlotMeta *next_meta = get_meta(allocator, meta->next, NO_EXPECTATION);
+    return next_meta->is_free && !next_meta->memory_is_owned
+           && next_meta->size + sizeof(GPMemorySlotMeta) >= size - meta->size
+           && next_meta->data - sizeof(*next_meta) == meta->data + meta->size;
+}
+
+/// grows an allocated GPA slot to size by merging it into its free, contiguous predecessor (and, if that is not enough,
+/// taking the rest from its free successor). The predecessor's meta becomes the meta of the grown slot, so the data is
+/// moved left by the size of the predecessor. Returns the new data pointer or NULL if the neighbours are too small.
+static void *grow_gpa_slot_backwards(Allocator *allocator, GPMemorySlotMeta *meta, const size_t size) {
+    if (meta->memory_is_owned)
+        // the slot is the first one of its region, so its predecessor belongs to another region
+        return NULL;
+    GPMemorySlotMeta *prev_meta = get_meta(allocator, meta->prev, NO_EXPECTATION);
+    if (prev_meta == meta || !prev_meta->is_free || prev_meta->data + prev_meta->size != (void *) meta)
+        return NULL;
+    GPMemorySlotMeta *next_meta = get_meta(allocator, meta->next, NO_EXPECTATION);
+    const int can_grow_forwards = next_meta != prev_meta && next_meta->is_free && !next_meta->memory_is_owned
+                                  && next_meta->data - sizeof(*next_meta) == meta->data + meta->size;
+    const size_t merged_size = prev_meta->size + sizeof(GPMemorySlotMeta) + meta->size;
+    if (merged_size + (can_grow_forwards ? next_meta->size + sizeof(GPMemorySlotMeta) : 0) < size)
+        return NULL;
+
+    void *old_data = meta->data;
+    const size_t old_data_size = meta->size;
+    if (merged_size < size)
+        consume_next_slot(allocator, meta, size - merged_size);
+
+    // merge the slot into its predecessor
+    unbind_from_sorted_free_list(allocator, prev_meta);
+    GPMemorySlotMeta *new_next_meta = get_meta(allocator, meta->next, NO_EXPECTATION);
+    prev_meta->size += sizeof(GPMemorySlotMeta) + meta->size;
+    prev_meta->next = meta->next;
+    prev_meta->is_free = 0;
+    prev_meta->is_decommitted = 0;
+    prev_meta->growth_streak = meta->growth_streak;
+    new_next_meta->prev = prev_meta->data;
+    if (allocator->gpa.first_slot == old_data)
+        allocator->gpa.first_slot = prev_meta->data;
+    // invalidate checksum of the merged slot
+    meta->checksum = 0;
+    refresh_checksum_of(allocator, prev_meta);
+    refresh_checksum_of(allocator, new_next_meta);
+
+    // the old meta is overwritten here, so it must not be accessed anymore
+    memmove(prev_meta->data, old_data, old_data_size);
+    if (prev_meta->size > size)
+        // give back what was not needed (which may fail if it is too small to be a slot of its own)
+        shrink_gpa_slot(allocator, prev_meta, size);
+    return prev_meta->data;
+}
+
 void *virtalloc_realloc_impl(Allocator *allocator, void *p, size_t size) {
     check_allocator(allocator);
     debug_print_enter_fn(allocator->block_logging, "virtalloc_realloc_impl");
-    allocator->pre_alloc_op(allocator);
 
-    if (!p)
+    if (!p) {
+        debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
         return virtalloc_malloc_impl(allocator, size, 0);
+    }
 
-    const GenericMemorySlotMeta *gm = p - sizeof(GenericMemorySlotMeta);
-    if (gm->meta_type != RR_META_TYPE_SLOT && gm->meta_type != GP_META_TYPE_SLOT && gm->meta_type !=
+    const unsigned char meta_type = get_meta_type(allocator, p);
+    if (meta_type != RR_META_TYPE_SLOT && meta_type != GP_META_TYPE_SLOT && meta_type !=
         GP_META_TYPE_EARLY_RELEASE_SLOT) {
         assert_external(0 && "invalid pointer: does not correspond to allocation");
+        debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
         return NULL;
     }
 
-    if (gm->meta_type == RR_META_TYPE_SLOT) {
+    if (meta_type == RR_META_TYPE_SLOT) {
         if (size <= MAX_TINY_ALLOCATION_SIZE - sizeof(SmallRRMemorySlotMeta)) {
             debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
             return p; // since all slots in RR allocator are the same size, no action is required
@@ -462,20 +1108,18 @@ void *virtalloc_realloc_impl(Allocator *allocator, void *p, size_t size) {
         // must relocate the memory to general purpose allocator
         void *new_memory = virtalloc_malloc_impl(allocator, size, 0);
         if (!new_memory) {
-            allocator->post_alloc_op(allocator);
             debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
             return NULL;
         }
         memmove(new_memory, p, MAX_TINY_ALLOCATION_SIZE - sizeof(SmallRRMemorySlotMeta));
         virtalloc_free_impl(allocator, p);
-        allocator->post_alloc_op(allocator);
+        debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
         return new_memory;
     }
 
     if (!size) {
         // free the slot
         virtalloc_free_impl(allocator, p);
-        allocator->post_alloc_op(allocator);
         debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
         return NULL;
     }
@@ -484,116 +1128,369 @@ void *virtalloc_realloc_impl(Allocator *allocator, void *p, size_t size) {
     const size_t og_size = size;
     size = get_gpa_compatible_size(allocator, size);
 
-    // normal slots (smaller than the release early size limit) can be grown or shrunk without relocation
-    if (gm->meta_type == GP_META_TYPE_SLOT) {
+    // normal slots (smaller than the release early size limit) can be grown or shrunk without relocation. The GPA lock
+    // is released before relocating because the new allocation may have to lock the SMA, which must be locked first.
+    // The size of the old slot is captured while the lock is held because get_meta updates the meta.
+    size_t old_data_size;
+    // the growth streak and headroom the allocation is relocated with if it has to be relocated to grow
+    unsigned char growth_streak = 0;
+    size_t headroom = 0;
+    if (meta_type == GP_META_TYPE_SLOT) {
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
         GPMemorySlotMeta *meta = get_meta(allocator, p, EXPECT_IS_ALLOCATED);
-        GPMemorySlotMeta *next_meta = get_meta(allocator, meta->next, NO_EXPECTATION);
-        const size_t growth_bytes = size - meta->size;
         assert_internal(
             meta->size >= MIN_LARGE_ALLOCATION_SIZE && "this allocation is smaller than the minimum allocation size");
 
-        if (size < meta->size) {
-            // downsize the slot
-            const size_t shaved_off = meta->size - size;
-            if (next_meta->is_free && next_meta->data - sizeof(*next_meta) == meta->data + meta->size) {
-                // merge it into the next slot because it is a free, contiguous neighbour slot
-                consume_prev_slot(allocator, next_meta, meta->size - size);
-            } else {
-                if (shaved_off < sizeof(GPMemorySlotMeta) + MIN_LARGE_ALLOCATION_SIZE) {
-                    // cannot realloc: would not create a usable memory slot (because it would be smaller than allowed)
-                    allocator->post_alloc_op(allocator);
-                    debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
-                    return p;
-                }
-                // create a new free slot
-                meta->size = size;
-                void *new_slot_data = meta->data + size + sizeof(GPMemorySlotMeta);
-                const GPMemorySlotMeta new_slot_meta_content = {
-                    .checksum = 0, .size = shaved_off - sizeof(GPMemorySlotMeta), .data = new_slot_data,
-                    .next = meta->next,
-                    .prev = meta->data, .next_bigger_free = NULL, .next_smaller_free = NULL,
-                    .time_to_checksum_check = 0,
-                    .memory_pointer_right_adjustment = 0, .is_free = 1, .memory_is_owned = 0, .__bit_padding1 = 0,
-                    .__padding = {0}, .__bit_padding2 = 0, .meta_type = GP_META_TYPE_SLOT
-                };
-                GPMemorySlotMeta *new_slot_meta_ptr = new_slot_data - sizeof(GPMemorySlotMeta);
-                *new_slot_meta_ptr = new_slot_meta_content;
-
-                // insert slot into normal linked list
-                meta->next = new_slot_data;
-                next_meta->prev = new_slot_data;
-
-                refresh_checksum_of(allocator, meta);
-                refresh_checksum_of(allocator, next_meta);
-                // redundant because insert_into_sorted_free_list does this anyway
-                // refresh_checksum_of(allocator, new_slot_meta_ptr);
-
-                insert_into_sorted_free_list(allocator, new_slot_meta_ptr);
-            }
-            allocator->post_alloc_op(allocator);
+        // the end of the slot may be headroom reserved by an earlier realloc, which the user is not considered to use
+        const size_t requested_size = get_gpa_slot_requested_size(meta);
+        if (size < requested_size) {
+            // if the tail is too small to be a slot of its own, the slot is left as is
+            shrink_and_trim_gpa_slot(allocator, meta, size);
+            meta->growth_streak = 0;
+            set_gpa_slot_requested_size(meta, size);
+            refresh_checksum_of(allocator, meta);
+            allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
             debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
             return p;
-        } else if (size == meta->size && (og_size >= MIN_LARGE_ALLOCATION_SIZE || allocator->no_rr_allocator)) {
+        } else if (size == requested_size && (og_size >= MIN_LARGE_ALLOCATION_SIZE || allocator->no_rr_allocator)) {
             // no need to do anything, except when og_size < MIN_LARGE_ALLOCATION_SIZE. In that case, we want to move
             // the data to an RR slot (if RRA is enabled) to reduce metadata overhead for small allocations.
-            return p;
-        } else if (size > meta->size && next_meta->is_free && next_meta->size + sizeof(GPMemorySlotMeta) >= growth_bytes
-                   && next_meta->data - sizeof(*next_meta) == meta->data + meta->size) {
-            // trying to grow slot (and there is adjacent free space to grow into)
-            consume_next_slot(allocator, meta, growth_bytes);
-            allocator->post_alloc_op(allocator);
+            allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
             debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
             return p;
+        } else if (size > requested_size) {
+            growth_streak = meta->growth_streak + (meta->growth_streak < UCHAR_MAX);
+            void *grown = NULL;
+            if (size <= meta->size) {
+                // the slot already has the headroom to grow
+                grown = p;
+                __atomic_fetch_add(&allocator->num_reallocs_grown_forwards, 1, __ATOMIC_RELAXED);
+            } else {
+                headroom = predict_growth_headroom(allocator, requested_size, size, growth_streak);
+                const size_t target_size = headroom && can_grow_gpa_slot_forwards(allocator, meta, size + headroom)
+                                               ? size + headroom
+                                               : size;
+                if (can_grow_gpa_slot_forwards(allocator, meta, target_size)) {
+                    // trying to grow slot (and there is adjacent free space of the same region to grow into)
+                    consume_next_slot(allocator, meta, target_size - meta->size);
+                    grown = p;
+                    __atomic_fetch_add(&allocator->num_reallocs_grown_forwards, 1, __ATOMIC_RELAXED);
+                } else {
+                    // moving the data left into a free predecessor is cheaper than finding a new slot and copying it
+                    grown = grow_gpa_slot_backwards(allocator, meta, size);
+                    if (grown)
+                        __atomic_fetch_add(&allocator->num_reallocs_grown_backwards, 1, __ATOMIC_RELAXED);
+                }
+            }
+            if (grown) {
+                GPMemorySlotMeta *grown_meta = grown == p ? meta : get_meta(allocator, grown, EXPECT_IS_ALLOCATED);
+                grown_meta->growth_streak = growth_streak;
+                set_gpa_slot_requested_size(grown_meta, size);
+                refresh_checksum_of(allocator, grown_meta);
+                allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+                debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
+                return grown;
+            }
         }
+        old_data_size = meta->size;
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
     } else {
-        assert_internal(gm->meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT && "unreachable");
-        const GPEarlyReleaseMeta *germ = get_early_rel_meta(allocator, p);
-        size = round_to_power_of_2(size);
-        if (size == germ->size)
-            // no need to relocate or resize, the buffer capacity is already available
-            return p;
+        assert_internal(meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT && "unreachable");
+        // the meta may be modified by the list of live early release blocks, which is protected by the backing lock
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        GPEarlyReleaseMeta *germ = get_early_rel_meta(allocator, p);
+        const int stays_early_release = size >= __atomic_load_n(&allocator->gpa.min_size_for_early_release,
+                                                                __ATOMIC_RELAXED);
+        // the block's size is rounded to whole pages, so it may lie between two size classes and still fit the
+        // exact size (e.g. when growing to the usable size) even though it doesn't fit the size class
+        const size_t class_size = round_to_size_class(size, EARLY_RELEASE_SIZE_CLASSES_PER_DOUBLING);
+        old_data_size = germ->size;
+        void *remapped = is_early_release_block_fit_for(germ->size, class_size)
+                         || is_early_release_block_fit_for(germ->size, size)
+                             // no need to relocate or resize, the buffer capacity is already available and not much
+                             // of it is wasted
+                             ? p
+                             : stays_early_release
+                                   ? remap_early_release_block(allocator, germ, class_size)
+                                   : NULL;
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        if (remapped) {
+            debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
+            return remapped;
+        }
     }
 
-    // must relocate the memory to grow the slot
-    void *new_memory = virtalloc_malloc_impl(allocator, og_size, 0);
+    // must relocate the memory to grow the slot (with headroom if further growth is expected)
+    void *new_memory = headroom ? virtalloc_malloc_impl(allocator, og_size + headroom, 0) : NULL;
+    if (!new_memory)
+        new_memory = virtalloc_malloc_impl(allocator, og_size, 0);
     if (!new_memory) {
-        allocator->post_alloc_op(allocator);
         debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
         return NULL;
     }
-    if (gm->meta_type == GP_META_TYPE_SLOT) {
-        const GPMemorySlotMeta *meta = get_meta(allocator, p, EXPECT_IS_ALLOCATED);
-        memmove(new_memory, p, min(meta->size, og_size));
-    } else {
-        const GPEarlyReleaseMeta *meta = get_early_rel_meta(allocator, p);
-        memmove(new_memory, p, min(meta->size, og_size));
-    }
+    // the new allocation never overlaps the old one, which is still allocated
+    relocation_copy(new_memory, p, min(old_data_size, og_size));
     virtalloc_free_impl(allocator, p);
-    allocator->post_alloc_op(allocator);
+    if (growth_streak && get_meta_type(allocator, new_memory) == GP_META_TYPE_SLOT) {
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
+        GPMemorySlotMeta *new_meta = get_meta(allocator, new_memory, EXPECT_IS_ALLOCATED);
+        new_meta->growth_streak = growth_streak;
+        if (new_meta->size >= size)
+            set_gpa_slot_requested_size(new_meta, size);
+        refresh_checksum_of(allocator, new_meta);
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    }
+    __atomic_fetch_add(&allocator->num_reallocs_relocated, 1, __ATOMIC_RELAXED);
     debug_print_leave_fn(allocator->block_logging, "virtalloc_realloc_impl");
     return new_memory;
 }
 
-void virtalloc_pre_op_callback_impl(Allocator *allocator) {
-    assert_internal(allocator->intra_thread_lock_count >= 0);
+int virtalloc_resize_in_place_impl(Allocator *allocator, void *p, size_t size, const int shrink) {
+    check_allocator(allocator);
+    assert_external(
+        p && "Illegal argument: p (pointer) parameter in virtalloc_try_expand/virtalloc_try_shrink call must be non-null");
+    debug_print_enter_fn(allocator->block_logging, "virtalloc_resize_in_place_impl");
+    const unsigned char meta_type = get_meta_type(allocator, p);
+    int resized;
+    if (meta_type == RR_META_TYPE_SLOT) {
+        // all slots in RR allocator are the same size
+        resized = size <= MAX_TINY_ALLOCATION_SIZE - sizeof(SmallRRMemorySlotMeta);
+    } else if (meta_type == GP_META_TYPE_SLOT) {
+        size = get_gpa_compatible_size(allocator, size);
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
+        GPMemorySlotMeta *meta = get_meta(allocator, p, EXPECT_IS_ALLOCATED);
+        if (size <= meta->size) {
+            resized = 1;
+            if (shrink) {
+                if (size < meta->size)
+                    shrink_and_trim_gpa_slot(allocator, meta, size);
+                meta->growth_streak = 0;
+                set_gpa_slot_requested_size(meta, size);
+            } else if (size > get_gpa_slot_requested_size(meta)) {
+                set_gpa_slot_requested_size(meta, size);
+            }
+        } else {
+            // growing backwards would move the data, so only the successor can be grown into
+            resized = !shrink && can_grow_gpa_slot_forwards(allocator, meta, size);
+            if (resized) {
+                consume_next_slot(allocator, meta, size - meta->size);
+                set_gpa_slot_requested_size(meta, size);
+            }
+        }
+        refresh_checksum_of(allocator, meta);
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    } else if (meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT) {
+        // remapping may move the block, so it can only be resized within the pages it already has
+        size = get_gpa_compatible_size(allocator, size);
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        resized = size <= get_early_rel_meta(allocator, p)->size;
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    } else {
+        assert_external(0 && "invalid pointer: does not correspond to allocation");
+        resized = 0;
+    }
+    debug_print_leave_fn(allocator->block_logging, "virtalloc_resize_in_place_impl");
+    return resized;
+}
+
+size_t virtalloc_usable_size_impl(Allocator *allocator, void *p) {
+    check_allocator(allocator);
+    assert_external(p && "Illegal argument: p (pointer) parameter in virtalloc_usable_size call must be non-null");
+    const unsigned char meta_type = get_meta_type(allocator, p);
+    size_t size;
+    if (meta_type == RR_META_TYPE_SLOT) {
+        return MAX_TINY_ALLOCATION_SIZE - sizeof(SmallRRMemorySlotMeta);
+    } else if (meta_type == GP_META_TYPE_SLOT) {
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
+        size = get_meta(allocator, p, EXPECT_IS_ALLOCATED)->size;
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    } else if (meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT) {
+        allocator->pre_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+        size = get_early_rel_meta(allocator, p)->size;
+        allocator->post_alloc_op(allocator, ALLOCATOR_PART_BACKING);
+    } else {
+        assert_external(0 && "invalid pointer passed to usable_size: not associated with any allocation");
+        return 0;
+    }
+    return get_gpa_usable_size(allocator, size);
+}
+
+/// splits the front of an allocated GPA slot off as a free slot so that the allocated slot starts at new_data. The front
+/// must be big enough to hold a free slot. Returns the meta of the allocated slot.
+static GPMemorySlotMeta *split_off_leading_free_slot(Allocator *allocator, GPMemorySlotMeta *meta, void *new_data) {
+    assert_internal(
+        (size_t) (new_data - meta->data) >= sizeof(GPMemorySlotMeta) + MIN_LARGE_ALLOCATION_SIZE
+        && new_data < meta->data + meta->size && "leading free slot would be too small or allocated slot would be empty");
+    GPMemorySlotMeta *next_meta = get_meta(allocator, meta->next, NO_EXPECTATION);
+    GPMemorySlotMeta *new_meta = new_data - sizeof(GPMemorySlotMeta);
+    // the allocated slot lies in the interior of the old one, so it inherits whether that is known to be zero-filled
+    *new_meta = (GPMemorySlotMeta){
+        .checksum = 0, .size = meta->data + meta->size - new_data, .data = new_data, .next = meta->next,
+        .prev = meta->data, .next_bigger_free = NULL, .next_smaller_free = NULL, .time_to_checksum_check = 0,
+        .memory_pointer_right_adjustment = 0, .is_free = 0, .memory_is_owned = 0,
+        .is_decommitted = meta->is_decommitted, .__bit_padding1 = 0, .growth_streak = 0, .unrequested_size = 0,
+        .__padding = {0}, .__bit_padding2 = 0, .meta_type = GP_META_TYPE_SLOT
+    };
+
+    // insert slot into normal linked list (next_meta may be meta itself if it was the only slot)
+    next_meta->prev = new_data;
+    meta->next = new_data;
+    meta->size = new_data - sizeof(GPMemorySlotMeta) - meta->data;
+    meta->is_free = 1;
+    refresh_checksum_of(allocator, next_meta);
+    refresh_checksum_of(allocator, new_meta);
+    refresh_checksum_of(allocator, meta);
+    coalesce_memory_slots(allocator, meta, 0);
+    return new_meta;
+}
+
+void *virtalloc_aligned_alloc_impl(Allocator *allocator, size_t alignment, size_t size) {
+    check_allocator(allocator);
+    debug_print_enter_fn(allocator->block_logging, "virtalloc_aligned_alloc_impl");
+    if (!alignment || alignment & (alignment - 1)) {
+        debug_print_leave_fn(allocator->block_logging, "virtalloc_aligned_alloc_impl");
+        return NULL;
+    }
+    // small slots do not even have the default alignment, so aligned allocations always go to the GPA
+    alignment = max(alignment, allocator->gpa.alignment);
+    size = get_gpa_compatible_size(allocator, size);
+
+    if (size >= __atomic_load_n(&allocator->gpa.min_size_for_early_release, __ATOMIC_RELAXED)
+        && allocator->request_new_memory) {
+        void *block = malloc_early_release_block(allocator, size, max(alignment, LARGE_ALLOCATION_ALIGN));
+        debug_print_leave_fn(allocator->block_logging, "virtalloc_aligned_alloc_impl");
+        return block;
+    }
+
+    // every slot of this size contains an aligned address with enough room for a free slot in front of it. Instead of
+    // keeping the over-allocation, the slot is split into a leading free slot, the aligned slot and a free tail.
+    const size_t search_size = alignment == allocator->gpa.alignment
+                                   ? size
+                                   : size + alignment + sizeof(GPMemorySlotMeta) + MIN_LARGE_ALLOCATION_SIZE;
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    void *p = gpa_malloc(allocator, search_size, 0);
+    if (p && search_size != size) {
+        GPMemorySlotMeta *meta = get_meta(allocator, p, EXPECT_IS_ALLOCATED);
+        void *aligned_p = (void *) align_to((size_t) p, alignment);
+        if (aligned_p != p) {
+            if ((size_t) (aligned_p - p) < sizeof(GPMemorySlotMeta) + MIN_LARGE_ALLOCATION_SIZE)
+                aligned_p += alignment;
+            meta = split_off_leading_free_slot(allocator, meta, aligned_p);
+            p = aligned_p;
+        }
+        shrink_gpa_slot(allocator, meta, size);
+    }
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
+    debug_print_leave_fn(allocator->block_logging, "virtalloc_aligned_alloc_impl");
+    return p;
+}
+
+/// which parts of the allocator a malloc of the given size may have to lock
+static int get_malloc_lock_parts(const Allocator *allocator, const size_t size) {
+    if (!allocator->no_rr_allocator && size < MAX_TINY_ALLOCATION_SIZE - sizeof(SmallRRMemorySlotMeta))
+        // growing the SMA may carve a chunk out of the GPA, which may in turn request new memory
+        return ALLOCATOR_PART_SMA | (allocator->sma_request_mem_from_gpa ? ALLOCATOR_PART_GPA : 0)
+               | ALLOCATOR_PART_BACKING;
+    if (get_gpa_compatible_size(allocator, size) >= __atomic_load_n(&allocator->gpa.min_size_for_early_release,
+                                                                    __ATOMIC_RELAXED)
+        && allocator->request_new_memory)
+        return ALLOCATOR_PART_BACKING;
+    return ALLOCATOR_PART_GPA | ALLOCATOR_PART_BACKING;
+}
+
+int virtalloc_try_malloc_impl(Allocator *allocator, const size_t size, void **out) {
+    *out = NULL;
+    const int parts = get_malloc_lock_parts(allocator, size);
+    // the locks are recursive, so once they are held, malloc will not block on them anymore
+    if (!allocator->assume_thread_safe_usage && !try_lock_allocator_parts(allocator, parts))
+        return VIRTALLOC_TRY_WOULD_BLOCK;
+    *out = allocator->malloc(allocator, size, 0);
     if (!allocator->assume_thread_safe_usage)
-        lock_virtual_allocator(allocator);
+        allocator->post_alloc_op(allocator, parts);
+    return *out ? VIRTALLOC_TRY_OK : VIRTALLOC_TRY_OUT_OF_MEMORY;
+}
+
+/// pushes p onto the given lock-free deferred free stack. The link is stored in the first word of p's data.
+static void push_deferred_free(void **stack, void *p) {
+    void *head = __atomic_load_n(stack, __ATOMIC_RELAXED);
+    do {
+        *(void **) p = head;
+    } while (!__atomic_compare_exchange_n(stack, &head, p, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/// frees every pointer on the given deferred free stack. Taking the whole stack at once avoids the ABA problem.
+static void drain_deferred_free_stack(Allocator *allocator, void **stack) {
+    void *p = __atomic_exchange_n(stack, NULL, __ATOMIC_ACQUIRE);
+    while (p) {
+        void *next = *(void **) p;
+        allocator->free(allocator, p);
+        p = next;
+    }
+}
+
+int virtalloc_try_free_impl(Allocator *allocator, void *p) {
+    assert_external(p && "Illegal argument: p (pointer) parameter in virtalloc_try_free call must be non-null");
+    const unsigned char meta_type = get_meta_type(allocator, p);
+    if (allocator->assume_thread_safe_usage || meta_type == RR_META_TYPE_SLOT) {
+        // small slots are freed without a lock anyway
+        allocator->free(allocator, p);
+        return VIRTALLOC_TRY_OK;
+    }
+    const int part = meta_type == GP_META_TYPE_SLOT ? ALLOCATOR_PART_GPA : ALLOCATOR_PART_BACKING;
+    if (!try_lock_allocator_parts(allocator, part)) {
+        push_deferred_free(part == ALLOCATOR_PART_GPA ? &allocator->deferred_gpa_frees
+                                                      : &allocator->deferred_backing_frees, p);
+        return VIRTALLOC_TRY_DEFERRED;
+    }
+    allocator->free(allocator, p);
+    allocator->post_alloc_op(allocator, part);
+    return VIRTALLOC_TRY_OK;
+}
+
+void virtalloc_drain_deferred_frees_impl(Allocator *allocator) {
+    drain_deferred_free_stack(allocator, &allocator->deferred_gpa_frees);
+    drain_deferred_free_stack(allocator, &allocator->deferred_backing_frees);
 }
 
-void virtalloc_post_op_callback_impl(Allocator *allocator) {
-    assert_internal(allocator->intra_thread_lock_count >= 0);
+void virtalloc_pre_op_callback_impl(Allocator *allocator, const int parts) {
     if (!allocator->assume_thread_safe_usage)
-        unlock_virtual_allocator(allocator);
+        lock_allocator_parts(allocator, parts);
 }
 
-void virtalloc_gpa_add_new_memory_impl(Allocator *allocator, void *p, size_t size) {
+void virtalloc_post_op_callback_impl(Allocator *allocator, const int parts) {
+    if (allocator->assume_thread_safe_usage)
+        return;
+    // the outermost holder of a lock does the frees that try_free deferred while the lock was held. Nested holders
+    // must not, because the operation that took the lock first may still be in the middle of modifying the heap.
+    if (parts & ALLOCATOR_PART_GPA && allocator->gpa_lock_depth == 1)
+        drain_deferred_free_stack(allocator, &allocator->deferred_gpa_frees);
+    if (parts & ALLOCATOR_PART_BACKING && allocator->backing_lock_depth == 1)
+        drain_deferred_free_stack(allocator, &allocator->deferred_backing_frees);
+    unlock_allocator_parts(allocator, parts);
+}
+
+void virtalloc_gpa_add_new_memory_impl(Allocator *allocator, void *p, const size_t size) {
+    // memory that may be decommitted comes from the OS backend, so it is freshly mapped and thus zero-filled
+    gpa_add_memory(allocator, p, size, 1, allocator->can_decommit);
+}
+
+/// adds the memory to the GPA as a free slot. If memory_is_owned is set, the region is released on destroy. If
+/// is_zero_filled is set, the memory is known to be untouched since the OS mapped it, so calloc doesn't have to zero it.
+static void gpa_add_memory(Allocator *allocator, void *p, size_t size, const int memory_is_owned,
+                           const int is_zero_filled) {
     assert_external(size >= sizeof(GPMemorySlotMeta) + MIN_LARGE_ALLOCATION_SIZE);
-    allocator->pre_alloc_op(allocator);
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_GPA);
 
-    const size_t right_adjustment = (LARGE_ALLOCATION_ALIGN - (size_t) p % LARGE_ALLOCATION_ALIGN) %
-                                    LARGE_ALLOCATION_ALIGN;
+    // with the page map, the region is shrunk to whole pages so that no registered page is shared with other memory
+    const size_t align = allocator->use_page_map ? PAGE_MAP_PAGE_SIZE : LARGE_ALLOCATION_ALIGN;
+    const size_t right_adjustment = (align - (size_t) p % align) % align;
     p += right_adjustment;
     size -= right_adjustment;
+    if (allocator->use_page_map) {
+        size = align_down(size, PAGE_MAP_PAGE_SIZE);
+        assert_external(size >= sizeof(GPMemorySlotMeta) + MIN_LARGE_ALLOCATION_SIZE);
+        page_map_set_range(p, size, GP_META_TYPE_SLOT);
+    }
     void *slot = p + sizeof(GPMemorySlotMeta);
 
     GPMemorySlotMeta *first_meta = NULL;
@@ -606,7 +1503,8 @@ void virtalloc_gpa_add_new_memory_impl(Allocator *allocator, void *p, size_t siz
         .checksum = 0, .size = size - sizeof(GPMemorySlotMeta), .data = slot,
         .next = first_meta ? first_meta->data : slot, .prev = last_meta ? last_meta->data : slot,
         .next_bigger_free = NULL, .next_smaller_free = NULL, .time_to_checksum_check = 0,
-        .memory_pointer_right_adjustment = right_adjustment, .is_free = 1, .memory_is_owned = 1, .__bit_padding1 = 0,
+        .memory_pointer_right_adjustment = right_adjustment, .is_free = 1, .memory_is_owned = memory_is_owned != 0,
+        .is_decommitted = is_zero_filled != 0, .__bit_padding1 = 0, .growth_streak = 0, .unrequested_size = 0,
         .__padding = {0}, .__bit_padding2 = 0, .meta_type = GP_META_TYPE_SLOT
     };
     *(GPMemorySlotMeta *) p = new_slot_meta_content;
@@ -626,29 +1524,37 @@ void virtalloc_gpa_add_new_memory_impl(Allocator *allocator, void *p, size_t siz
 
     // since owned slots have been added separately, the heap must be scanned at destroy time for those slots and
     // the release callback must be called on them -> enable that behavior
-    allocator->release_only_allocator = 0;
+    if (memory_is_owned)
+        __atomic_store_n(&allocator->release_only_allocator, 0, __ATOMIC_RELAXED);
 
-    allocator->post_alloc_op(allocator);
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_GPA);
 }
 
-void virtalloc_sma_add_new_memory_impl(Allocator *allocator, void *p, size_t size, const int must_free_later) {
+void virtalloc_sma_add_new_memory_impl(Allocator *allocator, SmallRRAllocator *sma, void *p, size_t size,
+                                       const int must_free_later) {
     assert_external(
         size >= sizeof(SmallRRNextSlotLinkMeta) + sizeof(SmallRRStartOfMemoryChunkMeta) + sizeof(SmallRRMemorySlotMeta)
         + MAX_TINY_ALLOCATION_SIZE);
-    allocator->pre_alloc_op(allocator);
+    allocator->pre_alloc_op(allocator, ALLOCATOR_PART_SMA);
 
     void *og_p = p;
 
-    // align p
-    const size_t right_adjustment = (MAX_TINY_ALLOCATION_SIZE - (size_t) p % MAX_TINY_ALLOCATION_SIZE) %
-                                    MAX_TINY_ALLOCATION_SIZE;
+    // align p (to a whole page with the page map, so that no registered page is shared with other memory)
+    const size_t align = allocator->use_page_map ? PAGE_MAP_PAGE_SIZE : MAX_TINY_ALLOCATION_SIZE;
+    const size_t right_adjustment = (align - (size_t) p % align) % align;
     p += right_adjustment;
     size -= right_adjustment;
+    if (allocator->use_page_map) {
+        size = align_down(size, PAGE_MAP_PAGE_SIZE);
+        assert_external(size >= sizeof(SmallRRStartOfMemoryChunkMeta) + 2 * MAX_TINY_ALLOCATION_SIZE);
+        page_map_set_range(p, size, RR_META_TYPE_SLOT);
+    }
     void *aligned_p = p;
 
     // add the SmallRRStartOfMemoryChunkMeta
     SmallRRStartOfMemoryChunkMeta mcm = {.must_release_chunk_on_destroy = must_free_later, .__padding = {0}};
     memmove(&mcm.memory_chunk_ptr_raw_bytes, &og_p, sizeof(og_p));
+    memmove(&mcm.chunk_size_raw_bytes, &size, sizeof(size));
     *(SmallRRStartOfMemoryChunkMeta *) p = mcm;
     p += sizeof(SmallRRStartOfMemoryChunkMeta);
     size -= sizeof(SmallRRStartOfMemoryChunkMeta);
@@ -667,27 +1573,28 @@ void virtalloc_sma_add_new_memory_impl(Allocator *allocator, void *p, size_t siz
     };
     p += sizeof(SmallRRNextSlotLinkMeta);
     // link back to the first slot (because that's what the last link in the chain does)
-    *(void **) p = allocator->sma.first_slot
-                       ? allocator->sma.first_slot
+    *(void **) p = sma->first_slot
+                       ? sma->first_slot
                        : aligned_p + sizeof(SmallRRStartOfMemoryChunkMeta) + sizeof(SmallRRMemorySlotMeta);
 
     // link the new slots to the existing chain
-    if (allocator->sma.first_slot) {
-        assert_internal(allocator->sma.last_slot && allocator->sma.rr_slot && "unreachable");
-        *(void **) allocator->sma.last_slot = aligned_p + sizeof(SmallRRStartOfMemoryChunkMeta) + sizeof(
+    if (sma->first_slot) {
+        assert_internal(sma->last_slot && sma->rr_slot && "unreachable");
+        *(void **) sma->last_slot = aligned_p + sizeof(SmallRRStartOfMemoryChunkMeta) + sizeof(
                                                   SmallRRMemorySlotMeta);
-        allocator->sma.last_slot = p;
+        sma->last_slot = p;
     } else {
-        assert_internal(!allocator->sma.last_slot && !allocator->sma.rr_slot && "unreachable");
-        allocator->sma.first_slot = aligned_p + sizeof(SmallRRStartOfMemoryChunkMeta) + sizeof(SmallRRMemorySlotMeta);
-        allocator->sma.last_slot = p;
+        assert_internal(!sma->last_slot && !sma->rr_slot && "unreachable");
+        sma->first_slot = aligned_p + sizeof(SmallRRStartOfMemoryChunkMeta) + sizeof(SmallRRMemorySlotMeta);
+        sma->last_slot = p;
     }
     // guaranteed free memory (also happens to be an easy OOM fix)
-    allocator->sma.rr_slot = aligned_p + sizeof(SmallRRStartOfMemoryChunkMeta) + sizeof(SmallRRMemorySlotMeta);
+    sma->rr_slot = aligned_p + sizeof(SmallRRStartOfMemoryChunkMeta) + sizeof(SmallRRMemorySlotMeta);
 
     // since owned slots have been added separately, the heap must be scanned at destroy time for those slots and
     // the release callback must be called on them -> enable that behavior
-    allocator->release_only_allocator = 0;
+    if (must_free_later)
+        __atomic_store_n(&allocator->release_only_allocator, 0, __ATOMIC_RELAXED);
 
-    allocator->post_alloc_op(allocator);
+    allocator->post_alloc_op(allocator, ALLOCATOR_PART_SMA);
 }
@@ -9,6 +9,7 @@
 #include "virtalloc/small_rr_memory_slot_meta.h"
 #include "virtalloc/math_utils.h"
 #include "virtalloc/helper_macros.h"
+#include "virtalloc/page_map.h"
 
 void dump_gp_slot_meta_to_file(FILE *file, GPMemorySlotMeta *meta, const size_t slot_num) {
     fprintf(file, "===== GENERAL PURPOSE SLOT %4zu (%p) =====\n", slot_num, meta->data);
@@ -20,6 +21,15 @@ void dump_gp_slot_meta_to_file(FILE *file, GPMemorySlotMeta *meta, const size_t
     fprintf(file, " ......\n");
 }
 
+void dump_early_release_meta_to_file(FILE *file, GPEarlyReleaseMeta *meta, const size_t block_num) {
+    fprintf(file, "===== EARLY RELEASE BLOCK %4zu (%p) =====\n", block_num, (void *) (meta + 1));
+    fprintf(file, "Size: %zu\n", meta->size);
+    fprintf(file, "Data: ");
+    for (size_t j = 0; j < 16; j++)
+        fprintf(file, "%x ", ((unsigned char *) (meta + 1))[j] % 256);
+    fprintf(file, " ......\n");
+}
+
 void dump_sm_slot_meta_to_file(FILE *file, SmallRRMemorySlotMeta *meta, const size_t slot_num) {
     fprintf(file, "===== SMALL SLOT %4zu (%p) =====\n", slot_num, (void *) meta + sizeof(SmallRRMemorySlotMeta));
     fprintf(file, "Size: %d\n", MAX_TINY_ALLOCATION_SIZE);
@@ -56,7 +66,7 @@ size_t get_bucket_index(const Allocator *allocator, const size_t size) {
     assert_internal(size >= MIN_LARGE_ALLOCATION_SIZE && "allocation smaller than smallest allowed allocation size");
     if (allocator->bucket_strategy == NO_BUCKETS)
         return 0;
-    return min(allocator->gpa.num_buckets - 1, (size - MIN_LARGE_ALLOCATION_SIZE) / LARGE_ALLOCATION_ALIGN);
+    return min(allocator->gpa.num_buckets - 1, (size - MIN_LARGE_ALLOCATION_SIZE) / allocator->gpa.alignment);
     // the more general approach is this binary search, but the above works for how we sample bucket sizes
     // return binary_search(size, allocator->gpa.num_buckets, allocator->gpa.bucket_sizes);
 }
@@ -127,6 +137,14 @@ void validate_checksum_of(const Allocator *allocator, void *meta, const int forc
             "checksum incorrect: you likely passed a pointer to free/realloc that does not correspond to an allocation or corrupted the allocator's metadata");
 }
 
+/// classifies the allocation p points to. Without the page map, this reads the meta type byte right in front of p.
+unsigned char get_meta_type(const Allocator *allocator, void *p) {
+    if (allocator->use_page_map)
+        return page_map_get(p);
+    const GenericMemorySlotMeta *gm = p - sizeof(GenericMemorySlotMeta);
+    return gm->meta_type;
+}
+
 GPMemorySlotMeta *get_meta(const Allocator *allocator, void *p, const int should_be_free) {
     assert_internal(p && "illegal argument: p must be non-null");
     debug_print_enter_fn(allocator->block_logging, "get_meta");
@@ -164,6 +182,10 @@ GPMemorySlotMeta *get_meta(const Allocator *allocator, void *p, const int should
     return meta;
 }
 
+int is_early_release_block_fit_for(const size_t block_size, const size_t size) {
+    return size <= block_size && block_size - size < block_size / EARLY_RELEASE_SIZE_CLASSES_PER_DOUBLING;
+}
+
 GPEarlyReleaseMeta *get_early_rel_meta(const Allocator *allocator, void *p) {
     debug_print_enter_fn(allocator->block_logging, "get_early_rel_meta");
     GPEarlyReleaseMeta *meta = p - sizeof(GPEarlyReleaseMeta);
@@ -199,21 +221,39 @@ GPEarlyReleaseMeta *get_early_rel_meta(const Allocator *allocator, void *p) {
 
 void *get_next_rr_slot(const Allocator *allocator, void *rr_slot) {
     assert_internal(!allocator->no_rr_allocator);
-    const SmallRRMemorySlotMeta *meta = rr_slot - sizeof(SmallRRMemorySlotMeta);
-    if (meta->meta_type == RR_META_TYPE_SLOT)
+    // the meta byte is loaded atomically because other threads may concurrently free the slot
+    const SmallRRMemorySlotMeta meta = load_rr_slot_meta(rr_slot - sizeof(SmallRRMemorySlotMeta));
+    if (meta.meta_type == RR_META_TYPE_SLOT)
         return rr_slot + MAX_TINY_ALLOCATION_SIZE;
-    if (meta->meta_type == RR_META_TYPE_LINK) {
+    if (meta.meta_type == RR_META_TYPE_LINK) {
         void *next_slot = *(void **) rr_slot;
         assert_internal(next_slot && "unreachable");
         // multi-redirect using links isn't allowed
-        const SmallRRMemorySlotMeta *next_meta = next_slot - sizeof(SmallRRMemorySlotMeta);
-        assert_internal(next_meta->meta_type == RR_META_TYPE_SLOT && "unreachable");
+        assert_internal(load_rr_slot_meta(next_slot - sizeof(SmallRRMemorySlotMeta)).meta_type == RR_META_TYPE_SLOT
+            && "unreachable");
         return next_slot;
     }
     assert_internal(0 && "unreachable");
     return NULL;
 }
 
+int is_in_reserved_heap(const Allocator *allocator, const void *p) {
+    if (!allocator->reserved_end)
+        return 1;
+    return p > (const void *) allocator && p < __atomic_load_n(&allocator->committed_end, __ATOMIC_RELAXED);
+}
+
+SmallRRMemorySlotMeta load_rr_slot_meta(const SmallRRMemorySlotMeta *meta) {
+    SmallRRMemorySlotMeta value;
+    __atomic_load(meta, &value, __ATOMIC_ACQUIRE);
+    return value;
+}
+
+void set_rr_slot_is_free(SmallRRMemorySlotMeta *meta, const int is_free) {
+    SmallRRMemorySlotMeta value = {.is_free = is_free != 0, .meta_type = RR_META_TYPE_SLOT};
+    __atomic_store(meta, &value, __ATOMIC_RELEASE);
+}
+
 static void coalesce_slot_with_next(Allocator *allocator, GPMemorySlotMeta *meta, GPMemorySlotMeta *next_meta,
                                     const int meta_requires_unbind, const int next_meta_requires_unbind,
                                     const int out_requires_bind) {
@@ -229,8 +269,9 @@ static void coalesce_slot_with_next(Allocator *allocator, GPMemorySlotMeta *meta
     GPMemorySlotMeta *next_next_meta = get_meta(allocator, next_meta->next, NO_EXPECTATION);
     meta->next = next_meta->next;
     next_next_meta->prev = meta->data;
-    // merge
+    // merge (the merged slot contains next_meta, so its interior is no longer known to be zero-filled)
     meta->size += next_meta->size + sizeof(GPMemorySlotMeta);
+    meta->is_decommitted = 0;
     // invalidate the checksum of the next meta to catch bugs more easily
     next_meta->checksum = 0;
 
@@ -244,8 +285,8 @@ static void coalesce_slot_with_next(Allocator *allocator, GPMemorySlotMeta *meta
     debug_print_leave_fn(allocator->block_logging, "coalesce_slot_with_next");
 }
 
-void coalesce_memory_slots(Allocator *allocator, GPMemorySlotMeta *meta,
-                           const int meta_requires_unbind_from_free_list) {
+GPMemorySlotMeta *coalesce_memory_slots(Allocator *allocator, GPMemorySlotMeta *meta,
+                                       const int meta_requires_unbind_from_free_list) {
     debug_print_enter_fn(allocator->block_logging, "coalesce_memory_slots");
     assert_internal(allocator && meta && "illegal usage: allocator and meta must not be NULL");
     assert_internal(
@@ -253,12 +294,13 @@ void coalesce_memory_slots(Allocator *allocator, GPMemorySlotMeta *meta,
     GPMemorySlotMeta *next_meta = get_meta(allocator, meta->next, NO_EXPECTATION);
     GPMemorySlotMeta *prev_meta = get_meta(allocator, meta->prev, NO_EXPECTATION);
 
-    // can only coalesce with next slot if it is free and forms a contiguous chunk with current slot in memory
-    const int coalesce_with_next = next_meta->is_free && next_meta->data - sizeof(*next_meta) == meta->data + meta->
-                                   size;
+    // can only coalesce with next slot if it is free and forms a contiguous chunk with current slot in memory. Owned
+    // slots start a separately requested region and must stay separate so the region can be released on its own.
+    const int coalesce_with_next = next_meta->is_free && !next_meta->memory_is_owned
+                                   && next_meta->data - sizeof(*next_meta) == meta->data + meta->size;
     // can only coalesce with previous slot if it is free and forms a contiguous chunk with current slot in memory
-    const int coalesce_with_prev = prev_meta->is_free && meta->data - sizeof(*meta) == prev_meta->data + prev_meta->
-                                   size;
+    const int coalesce_with_prev = prev_meta->is_free && !meta->memory_is_owned
+                                   && meta->data - sizeof(*meta) == prev_meta->data + prev_meta->size;
 
     if (coalesce_with_next)
         coalesce_slot_with_next(allocator, meta, next_meta, meta_requires_unbind_from_free_list, 1,
@@ -272,6 +314,7 @@ void coalesce_memory_slots(Allocator *allocator, GPMemorySlotMeta *meta,
     if (!coalesce_with_next && !coalesce_with_prev && !meta_requires_unbind_from_free_list)
         insert_into_sorted_free_list(allocator, meta);
     debug_print_leave_fn(allocator->block_logging, "coalesce_slot_with_next");
+    return coalesce_with_prev ? prev_meta : meta;
 }
 
 static void try_coalesce_bbt_children(const Allocator *allocator, GPBucketTreeNode *parent, GPBucketTreeNode *left,
@@ -643,9 +686,10 @@ void consume_prev_slot(Allocator *allocator, GPMemorySlotMeta *meta, size_t move
         // unbind references to consumed block in normal linked list
         meta->prev = prev_meta->prev;
 
-        // move the metadata of the free slot to the left
+        // move the metadata of the free slot to the left (the slot now contains previously allocated memory)
         memmove((void *) meta - moved_bytes, meta, sizeof(*meta));
         meta = (void *) meta - moved_bytes;
+        meta->is_decommitted = 0;
         refresh_checksum_of(allocator, meta);
 
         // don't have to update prev_meta->prev because meta is moved to exactly where prev_meta used to be
@@ -659,9 +703,10 @@ void consume_prev_slot(Allocator *allocator, GPMemorySlotMeta *meta, size_t move
         // invalidate checksum of slot artifact (so that pre-move slot is invalidated)
         meta->checksum = 0;
 
-        // move the metadata of the free slot (meta) to the left
+        // move the metadata of the free slot (meta) to the left (the slot now contains previously allocated memory)
         memmove((void *) meta - moved_bytes, meta, sizeof(*meta));
         meta = (GPMemorySlotMeta *) ((void *) meta - moved_bytes);
+        meta->is_decommitted = 0;
         // adjust sizes
         meta->size += moved_bytes;
         meta->data -= moved_bytes;
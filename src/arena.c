@@ -0,0 +1,90 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <memory.h>
+#include "virtalloc/arena.h"
+#include "virtalloc/allocator_impl.h"
+#include "virtalloc/allocator_settings.h"
+#include "virtalloc/math_utils.h"
+#include "virtalloc/helper_macros.h"
+
+/// whether size can be aligned and put into a chunk of its own without overflowing
+static int is_valid_allocation_size(const size_t size) {
+    return size <= SIZE_MAX - ARENA_ALLOCATION_ALIGN - sizeof(ArenaChunk);
+}
+
+Arena *arena_create(Allocator *allocator, const size_t chunk_size) {
+    if (!is_valid_allocation_size(chunk_size))
+        return NULL;
+    Arena *arena = virtalloc_malloc_impl(allocator, sizeof(Arena), 0);
+    if (!arena)
+        return NULL;
+    *arena = (Arena){
+        .allocator = allocator, .chunk_size = align_to(max(chunk_size, ARENA_MIN_CHUNK_SIZE), ARENA_ALLOCATION_ALIGN),
+        .current = NULL, .cursor = NULL
+    };
+    return arena;
+}
+
+/// makes a new chunk with room for at least size bytes the current chunk. Returns 0 if it could not be allocated.
+static int push_chunk(Arena *arena, const size_t size) {
+    const size_t data_size = max(arena->chunk_size, size);
+    ArenaChunk *chunk = virtalloc_malloc_impl(arena->allocator, sizeof(ArenaChunk) + data_size, 0);
+    if (!chunk)
+        return 0;
+    chunk->prev = arena->current;
+    chunk->end = (void *) (chunk + 1) + data_size;
+    arena->current = chunk;
+    arena->cursor = chunk + 1;
+    return 1;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    if (!is_valid_allocation_size(size))
+        return NULL;
+    size = align_to(size, ARENA_ALLOCATION_ALIGN);
+    if (!arena->current || (size_t) (arena->current->end - arena->cursor) < size) {
+        // the rest of the current chunk is wasted, but that's what a bump allocator does
+        if (!push_chunk(arena, size))
+            return NULL;
+    }
+    void *p = arena->cursor;
+    arena->cursor += size;
+    return p;
+}
+
+void *arena_realloc(Arena *arena, void *p, const size_t old_size, const size_t new_size) {
+    if (!p)
+        return arena_alloc(arena, new_size);
+    if (!is_valid_allocation_size(new_size))
+        return NULL;
+    const size_t aligned_old_size = align_to(old_size, ARENA_ALLOCATION_ALIGN);
+    const size_t aligned_new_size = align_to(new_size, ARENA_ALLOCATION_ALIGN);
+    if (p + aligned_old_size == arena->cursor && (size_t) (arena->current->end - p) >= aligned_new_size) {
+        // p is the most recent allocation, so it can be resized by moving the cursor
+        arena->cursor = p + aligned_new_size;
+        return p;
+    }
+    if (aligned_new_size <= aligned_old_size)
+        // older allocations can't give memory back, but they don't need to move to shrink either
+        return p;
+    void *new_p = arena_alloc(arena, new_size);
+    if (new_p)
+        memcpy(new_p, p, min(old_size, new_size));
+    return new_p;
+}
+
+void arena_reset_to_mark(Arena *arena, void *mark) {
+    // the mark may be the end of its chunk, so the end is part of the range
+    while (arena->current && !((void *) (arena->current + 1) <= mark && mark <= arena->current->end)) {
+        ArenaChunk *prev = arena->current->prev;
+        virtalloc_free_impl(arena->allocator, arena->current);
+        arena->current = prev;
+    }
+    assert_external((arena->current || !mark) && "invalid mark: does not belong to this arena or was reset already");
+    arena->cursor = arena->current ? mark : NULL;
+}
+
+void arena_destroy(Arena *arena) {
+    arena_reset_to_mark(arena, NULL);
+    virtalloc_free_impl(arena->allocator, arena);
+}
@@ -4,7 +4,12 @@ void init_lock(ThreadLock *lock) {
 #ifdef _WIN32
     InitializeCriticalSection(&lock->win_lock);
 #else
-    pthread_mutex_init(&lock->pthread_lock, NULL);
+    // recursive because allocator operations call each other (e.g. realloc calls malloc) while holding the lock
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&lock->pthread_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
 #endif
 }
 
@@ -24,6 +29,14 @@ void lock(ThreadLock *lock) {
 #endif
 }
 
+int try_lock(ThreadLock *lock) {
+#ifdef _WIN32
+    return TryEnterCriticalSection(&lock->win_lock) != 0;
+#else
+    return pthread_mutex_trylock(&lock->pthread_lock) == 0;
+#endif
+}
+
 void unlock(ThreadLock *lock) {
 #ifdef _WIN32
     LeaveCriticalSection(&lock->win_lock);
@@ -0,0 +1,123 @@
+#include <stddef.h>
+#include "virtalloc/early_release_cache.h"
+#include "virtalloc/allocator_settings.h"
+#include "virtalloc/math_utils.h"
+#include "virtalloc/allocator_utils.h"
+#include "virtalloc/helper_macros.h"
+
+/// the list node stored in the data section of a cached block
+typedef struct EarlyReleaseCacheEntry {
+    /// the next more recently cached block of the same size class
+    struct EarlyReleaseCacheEntry *newer;
+    /// the next less recently cached block of the same size class
+    struct EarlyReleaseCacheEntry *older;
+    /// the cache's tick when the block was cached
+    size_t cached_at;
+} EarlyReleaseCacheEntry;
+
+static GPEarlyReleaseMeta *get_entry_meta(EarlyReleaseCacheEntry *entry) {
+    return (GPEarlyReleaseMeta *) entry - 1;
+}
+
+static void unlink_entry(EarlyReleaseCache *cache, const int size_class, EarlyReleaseCacheEntry *entry) {
+    if (entry->newer)
+        entry->newer->older = entry->older;
+    else
+        cache->newest[size_class] = entry->older;
+    if (entry->older)
+        entry->older->newer = entry->newer;
+    else
+        cache->oldest[size_class] = entry->newer;
+    if (!cache->newest[size_class])
+        cache->nonempty_classes &= ~((size_t) 1 << size_class);
+    cache->cached_bytes -= get_entry_meta(entry)->size;
+}
+
+/// releases the least recently cached block of the given size class
+static size_t evict_oldest_of(Allocator *allocator, const int size_class) {
+    EarlyReleaseCacheEntry *entry = allocator->early_release_cache.oldest[size_class];
+    GPEarlyReleaseMeta *meta = get_entry_meta(entry);
+    const size_t size = meta->size;
+    unlink_entry(&allocator->early_release_cache, size_class, entry);
+    if (allocator->release_memory)
+        allocator->release_memory(meta->data);
+    return size;
+}
+
+/// releases the least recently cached block of all size classes. The cache must not be empty.
+static void evict_oldest(Allocator *allocator) {
+    const EarlyReleaseCache *cache = &allocator->early_release_cache;
+    assert_internal(cache->nonempty_classes && "unreachable");
+    int oldest_class = -1;
+    for (size_t classes = cache->nonempty_classes; classes; classes &= classes - 1) {
+        const int size_class = __builtin_ctzl(classes);
+        if (oldest_class < 0 || cache->oldest[size_class]->cached_at < cache->oldest[oldest_class]->cached_at)
+            oldest_class = size_class;
+    }
+    evict_oldest_of(allocator, oldest_class);
+}
+
+/// advances the cache's clock and releases all blocks that have been cached for longer than the maximum age
+static void age_cache(Allocator *allocator) {
+    EarlyReleaseCache *cache = &allocator->early_release_cache;
+    cache->tick++;
+    for (size_t classes = cache->nonempty_classes; classes; classes &= classes - 1) {
+        const int size_class = __builtin_ctzl(classes);
+        while (cache->oldest[size_class] && cache->tick - cache->oldest[size_class]->cached_at >
+               EARLY_RELEASE_CACHE_MAX_AGE)
+            evict_oldest_of(allocator, size_class);
+    }
+}
+
+GPEarlyReleaseMeta *early_release_cache_take(Allocator *allocator, const size_t size) {
+    EarlyReleaseCache *cache = &allocator->early_release_cache;
+    if (!cache->nonempty_classes)
+        return NULL;
+    age_cache(allocator);
+    // blocks are cached in the class of the largest power of 2 that fits into them. A power of 2 class spans several
+    // early release size classes, so the blocks in it do not necessarily fit.
+    const int size_class = ilog2l(size);
+    for (EarlyReleaseCacheEntry *entry = cache->newest[size_class]; entry; entry = entry->older) {
+        if (is_early_release_block_fit_for(get_entry_meta(entry)->size, size)) {
+            unlink_entry(cache, size_class, entry);
+            return get_entry_meta(entry);
+        }
+    }
+    return NULL;
+}
+
+int early_release_cache_put(Allocator *allocator, GPEarlyReleaseMeta *meta) {
+    EarlyReleaseCache *cache = &allocator->early_release_cache;
+    if (meta->size > cache->max_bytes)
+        return 0;
+    age_cache(allocator);
+    while (cache->cached_bytes + meta->size > cache->max_bytes)
+        evict_oldest(allocator);
+
+    const int size_class = ilog2l(meta->size);
+    EarlyReleaseCacheEntry *entry = (EarlyReleaseCacheEntry *) (meta + 1);
+    *entry = (EarlyReleaseCacheEntry){.newer = NULL, .older = cache->newest[size_class], .cached_at = cache->tick};
+    if (entry->older)
+        entry->older->newer = entry;
+    else
+        cache->oldest[size_class] = entry;
+    cache->newest[size_class] = entry;
+    cache->nonempty_classes |= (size_t) 1 << size_class;
+    cache->cached_bytes += meta->size;
+    return 1;
+}
+
+void early_release_cache_set_limit(Allocator *allocator, const size_t max_bytes) {
+    EarlyReleaseCache *cache = &allocator->early_release_cache;
+    cache->max_bytes = max_bytes;
+    while (cache->cached_bytes > max_bytes)
+        evict_oldest(allocator);
+}
+
+size_t early_release_cache_flush(Allocator *allocator) {
+    EarlyReleaseCache *cache = &allocator->early_release_cache;
+    size_t released = 0;
+    while (cache->nonempty_classes)
+        released += evict_oldest_of(allocator, __builtin_ctzl(cache->nonempty_classes));
+    return released;
+}
@@ -0,0 +1,51 @@
+#include "virtalloc/exploration_tuner.h"
+#include "virtalloc/allocator_settings.h"
+#include "virtalloc/math_utils.h"
+#include "virtalloc/helper_macros.h"
+
+#define FIXED_POINT_ONE ((size_t) 1 << EXPLORATION_TUNER_FIXED_POINT_SHIFT)
+
+/// moves the estimate 1/2^EXPLORATION_TUNER_EWMA_SHIFT of the way towards the sample
+static void update_ewma(size_t *estimate, const size_t sample) {
+    if (sample >= *estimate)
+        *estimate += (sample - *estimate) >> EXPLORATION_TUNER_EWMA_SHIFT;
+    else
+        *estimate -= (*estimate - sample) >> EXPLORATION_TUNER_EWMA_SHIFT;
+}
+
+void exploration_tuner_enable(ExplorationTuner *tuner, size_t *budget, const size_t target_probes) {
+    assert_external(target_probes > 0 && "illegal argument: target probes must be positive");
+    *tuner = (ExplorationTuner){
+        .avg_probes = 0, .occupancy = 0, .hit_rate = FIXED_POINT_ONE, .target_probes = target_probes,
+        .min_budget = DEFAULT_MIN_EXPLORATION_STEPS, .max_budget = DEFAULT_MAX_EXPLORATION_STEPS, .is_enabled = 1
+    };
+    *budget = max(tuner->min_budget, min(tuner->max_budget, DEFAULT_EXPLORATION_STEPS_BEFORE_RR_OOM));
+}
+
+void exploration_tuner_record(ExplorationTuner *tuner, size_t *budget, const size_t probes, const size_t misses,
+                              const int hit) {
+    if (!tuner->is_enabled)
+        return;
+    assert_internal(misses <= probes && "unreachable");
+    const size_t capped_probes = min(probes, tuner->max_budget);
+    update_ewma(&tuner->avg_probes, capped_probes << EXPLORATION_TUNER_FIXED_POINT_SHIFT);
+    if (probes)
+        update_ewma(&tuner->occupancy, (misses << EXPLORATION_TUNER_FIXED_POINT_SHIFT) / probes);
+    update_ewma(&tuner->hit_rate, hit ? FIXED_POINT_ONE : 0);
+
+    const size_t target = tuner->target_probes << EXPLORATION_TUNER_FIXED_POINT_SHIFT;
+    if (tuner->avg_probes > target) {
+        // searches are too long: give up sooner and let the allocator grow instead
+        *budget = max(tuner->min_budget, *budget - *budget / 8);
+    } else if (tuner->avg_probes < target / 2 && tuner->hit_rate < FIXED_POINT_ONE - FIXED_POINT_ONE / 8) {
+        // searches are cheap but often fail: explore more before growing to keep the allocator small
+        *budget = min(tuner->max_budget, *budget + *budget / 8 + 1);
+    }
+}
+
+int exploration_tuner_should_grow(const ExplorationTuner *tuner, const size_t probes) {
+    if (!tuner->is_enabled || probes >= tuner->max_budget)
+        return 1;
+    return tuner->occupancy * EXPLORATION_TUNER_GROW_OCCUPANCY_DEN
+           >= FIXED_POINT_ONE * EXPLORATION_TUNER_GROW_OCCUPANCY_NUM;
+}
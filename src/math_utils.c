@@ -17,6 +17,15 @@ size_t round_to_power_of_2(size_t x) {
     return ++x;
 }
 
+size_t round_to_size_class(const size_t x, const size_t classes_per_doubling) {
+    if (x <= classes_per_doubling)
+        return round_to_power_of_2(x);
+    // the step is a fraction of the largest power of 2 below x, so sizes in [2^k, 2^(k + 1)] are rounded to multiples
+    // of 2^k / classes_per_doubling
+    const size_t step = ((size_t) 1 << ilog2l(x - 1)) / classes_per_doubling;
+    return align_to(x, step);
+}
+
 static const int tab64[64] = {
     63, 0, 58, 1, 59, 47, 53, 2,
     60, 39, 48, 27, 54, 33, 42, 3,
@@ -0,0 +1,168 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // for mremap
+#endif
+#include <stddef.h>
+#include "virtalloc/os_memory.h"
+#include "virtalloc/allocator_settings.h"
+#include "virtalloc/math_utils.h"
+
+// every mapping starts with a header that stores the length of the mapping, because release_memory only gets the
+// pointer. The header is LARGE_ALLOCATION_ALIGN bytes big so the returned memory keeps the mapping's alignment.
+#define OS_MEMORY_HEADER_SIZE LARGE_ALLOCATION_ALIGN
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+static void *map_memory(const size_t size, const int use_huge_pages) {
+    (void) use_huge_pages; // large pages require special privileges on windows, so they are not used
+    return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+static void *reserve_address_space(const size_t size) {
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+int os_commit_memory(void *p, const size_t size) {
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
+int os_decommit_memory(void *p, const size_t size) {
+    // decommitting and recommitting immediately gives back the physical memory, but keeps the range usable
+    return VirtualFree(p, size, MEM_DECOMMIT) && VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
+static void unmap_memory(void *p, const size_t size) {
+    (void) size;
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+static void *remap_memory(void *p, const size_t old_size, const size_t new_size) {
+    (void) p;
+    (void) old_size;
+    (void) new_size;
+    return NULL;
+}
+
+#else
+
+#include <sys/mman.h>
+
+static void *map_memory(const size_t size, const int use_huge_pages) {
+#ifdef MAP_HUGETLB
+    if (use_huge_pages) {
+        // explicit huge pages only work if the system has reserved some (vm.nr_hugepages), so this often fails
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+            return p;
+    }
+#endif
+    if (!use_huge_pages) {
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return p == MAP_FAILED ? NULL : p;
+    }
+
+    // transparent huge pages can only back huge page aligned memory, so over-map and cut off the unaligned ends
+    void *raw = mmap(NULL, size + OS_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return NULL;
+    void *p = (void *) align_to((size_t) raw, OS_HUGE_PAGE_SIZE);
+    if (p != raw)
+        munmap(raw, p - raw);
+    munmap(p + size, raw + OS_HUGE_PAGE_SIZE - p);
+#ifdef MADV_HUGEPAGE
+    // only a hint, THP may be disabled system-wide
+    madvise(p, size, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+static void *reserve_address_space(const size_t size) {
+    // MAP_NORESERVE: the reservation must not count against the overcommit limit until it is committed
+    void *p = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+int os_commit_memory(void *p, const size_t size) {
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+int os_decommit_memory(void *p, const size_t size) {
+    // MADV_FREE would be cheaper, but it does not guarantee that the pages read as zero afterwards
+    return madvise(p, size, MADV_DONTNEED) == 0;
+}
+
+static void unmap_memory(void *p, const size_t size) {
+    munmap(p, size);
+}
+
+static void *remap_memory(void *p, const size_t old_size, const size_t new_size) {
+#ifdef MREMAP_MAYMOVE
+    // the kernel moves the page table entries instead of copying the content
+    void *new_p = mremap(p, old_size, new_size, MREMAP_MAYMOVE);
+    return new_p == MAP_FAILED ? NULL : new_p;
+#else
+    (void) p;
+    (void) old_size;
+    (void) new_size;
+    return NULL;
+#endif
+}
+
+#endif
+
+static void *request_memory(const size_t min_size, int use_huge_pages) {
+    // rounding small requests (e.g. early release blocks) up to a huge page would waste more than half of it
+    use_huge_pages = use_huge_pages && min_size + OS_MEMORY_HEADER_SIZE > OS_HUGE_PAGE_SIZE / 2;
+    const size_t size = align_to(min_size + OS_MEMORY_HEADER_SIZE, use_huge_pages ? OS_HUGE_PAGE_SIZE : OS_PAGE_SIZE);
+    void *mapping = map_memory(size, use_huge_pages);
+    if (!mapping)
+        return NULL;
+    *(size_t *) mapping = size;
+    void *p = mapping + OS_MEMORY_HEADER_SIZE;
+    *(size_t *) p = size - OS_MEMORY_HEADER_SIZE;
+    return p;
+}
+
+void *os_request_memory(const size_t min_size) {
+    return request_memory(min_size, 0);
+}
+
+void *os_request_huge_page_memory(const size_t min_size) {
+    return request_memory(min_size, 1);
+}
+
+void *os_reserve_memory(const size_t reserve_size, const size_t commit_size, void **reserved_end) {
+    const size_t size = align_to(reserve_size + OS_MEMORY_HEADER_SIZE, OS_PAGE_SIZE);
+    const size_t committed_size = align_to(commit_size + OS_MEMORY_HEADER_SIZE, OS_PAGE_SIZE);
+    if (committed_size > size)
+        return NULL;
+    void *mapping = reserve_address_space(size);
+    if (!mapping)
+        return NULL;
+    if (!os_commit_memory(mapping, committed_size)) {
+        unmap_memory(mapping, size);
+        return NULL;
+    }
+    *(size_t *) mapping = size;
+    void *p = mapping + OS_MEMORY_HEADER_SIZE;
+    *(size_t *) p = committed_size - OS_MEMORY_HEADER_SIZE;
+    *reserved_end = mapping + size;
+    return p;
+}
+
+void *os_resize_memory(void *p, const size_t min_size, size_t *granted_size) {
+    void *mapping = p - OS_MEMORY_HEADER_SIZE;
+    const size_t size = align_to(min_size + OS_MEMORY_HEADER_SIZE, OS_PAGE_SIZE);
+    void *new_mapping = size == *(size_t *) mapping ? mapping : remap_memory(mapping, *(size_t *) mapping, size);
+    if (!new_mapping)
+        return NULL;
+    *(size_t *) new_mapping = size;
+    *granted_size = size - OS_MEMORY_HEADER_SIZE;
+    return new_mapping + OS_MEMORY_HEADER_SIZE;
+}
+
+void os_release_memory(void *p) {
+    void *mapping = p - OS_MEMORY_HEADER_SIZE;
+    unmap_memory(mapping, *(size_t *) mapping);
+}
@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include "virtalloc/page_map.h"
+#include "virtalloc/allocator_settings.h"
+#include "virtalloc/math_utils.h"
+#include "virtalloc/helper_macros.h"
+
+// a 3 level radix tree over the page number of a 48-bit virtual address. With 4 KiB pages, the page number has 36 bits,
+// which are split into 12 bits per level. The inner nodes are arrays of pointers, the leaves are arrays of meta types.
+#define PAGE_MAP_ADDRESS_BITS 48
+#define PAGE_MAP_PAGE_BITS (__builtin_ctzl(PAGE_MAP_PAGE_SIZE))
+#define PAGE_MAP_LEVEL_BITS 12
+#define PAGE_MAP_LEVEL_SIZE ((size_t) 1 << PAGE_MAP_LEVEL_BITS)
+#define PAGE_MAP_LEVEL_MASK (PAGE_MAP_LEVEL_SIZE - 1)
+
+typedef struct PageMapLeaf {
+    unsigned char meta_types[PAGE_MAP_LEVEL_SIZE];
+} PageMapLeaf;
+
+typedef struct PageMapNode {
+    PageMapLeaf *leaves[PAGE_MAP_LEVEL_SIZE];
+} PageMapNode;
+
+static PageMapNode *page_map_root[PAGE_MAP_LEVEL_SIZE];
+
+/// returns the child at slot, lazily creating it. Creation is lock-free: if two threads race, the loser frees its copy.
+static void *get_or_create_child(void **slot, const size_t child_size) {
+    void *child = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (child)
+        return child;
+    void *new_child = calloc(1, child_size);
+    assert_external(new_child && "failed to allocate page map node");
+    void *expected = NULL;
+    if (__atomic_compare_exchange_n(slot, &expected, new_child, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return new_child;
+    free(new_child);
+    return expected;
+}
+
+static unsigned char *get_entry(const void *p, const int create) {
+    const size_t page = (size_t) p >> PAGE_MAP_PAGE_BITS;
+    assert_external(
+        ((size_t) p >> PAGE_MAP_ADDRESS_BITS) == 0 && "page map only supports 48-bit virtual addresses");
+    const size_t i0 = (page >> 2 * PAGE_MAP_LEVEL_BITS) & PAGE_MAP_LEVEL_MASK;
+    const size_t i1 = (page >> PAGE_MAP_LEVEL_BITS) & PAGE_MAP_LEVEL_MASK;
+    const size_t i2 = page & PAGE_MAP_LEVEL_MASK;
+
+    PageMapNode *node = create
+                            ? get_or_create_child((void **) &page_map_root[i0], sizeof(PageMapNode))
+                            : __atomic_load_n(&page_map_root[i0], __ATOMIC_ACQUIRE);
+    if (!node)
+        return NULL;
+    PageMapLeaf *leaf = create
+                            ? get_or_create_child((void **) &node->leaves[i1], sizeof(PageMapLeaf))
+                            : __atomic_load_n(&node->leaves[i1], __ATOMIC_ACQUIRE);
+    if (!leaf)
+        return NULL;
+    return &leaf->meta_types[i2];
+}
+
+static void page_map_write_range(const void *p, const size_t size, const unsigned char meta_type) {
+    if (!size)
+        return;
+    const void *first_page = (const void *) align_down((size_t) p, PAGE_MAP_PAGE_SIZE);
+    const void *end = (const void *) align_to((size_t) p + size, PAGE_MAP_PAGE_SIZE);
+    for (const void *page = first_page; page < end; page += PAGE_MAP_PAGE_SIZE) {
+        unsigned char *entry = get_entry(page, meta_type != 0);
+        if (entry)
+            __atomic_store_n(entry, meta_type, __ATOMIC_RELEASE);
+    }
+}
+
+void page_map_set_range(const void *p, const size_t size, const unsigned char meta_type) {
+    assert_internal(meta_type && "illegal argument: meta type 0 is reserved for unregistered pages");
+    page_map_write_range(p, size, meta_type);
+}
+
+void page_map_clear_range(const void *p, const size_t size) {
+    page_map_write_range(p, size, 0);
+}
+
+unsigned char page_map_get(const void *p) {
+    const unsigned char *entry = get_entry(p, 0);
+    return entry ? __atomic_load_n(entry, __ATOMIC_ACQUIRE) : 0;
+}
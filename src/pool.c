@@ -0,0 +1,115 @@
+#include <stddef.h>
+#include "virtalloc/pool.h"
+#include "virtalloc/allocator_impl.h"
+#include "virtalloc/allocator_settings.h"
+#include "virtalloc/math_utils.h"
+#include "virtalloc/helper_macros.h"
+
+Pool *pool_create(Allocator *allocator, size_t object_size, size_t align) {
+    if (!align)
+        align = POOL_DEFAULT_ALIGN;
+    if (align & (align - 1) || align > POOL_SLAB_SIZE / 2)
+        return NULL;
+    // freed objects store the free list link in their first word
+    object_size = max(object_size, sizeof(void *));
+    align = max(align, _Alignof(void *));
+    const size_t object_stride = align_to(object_size, align);
+    const size_t first_object_offset = align_to(sizeof(PoolSlab), align);
+    if (first_object_offset + object_stride > POOL_SLAB_SIZE)
+        return NULL;
+    Pool *pool = virtalloc_malloc_impl(allocator, sizeof(Pool), 0);
+    if (!pool)
+        return NULL;
+    *pool = (Pool){
+        .allocator = allocator, .object_stride = object_stride, .first_object_offset = first_object_offset,
+        .objects_per_slab = (POOL_SLAB_SIZE - first_object_offset) / object_stride, .partial_slabs = NULL,
+        .full_slabs = NULL, .num_slabs = 0
+    };
+    return pool;
+}
+
+static void push_slab(PoolSlab **list, PoolSlab *slab) {
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list)
+        (*list)->prev = slab;
+    *list = slab;
+}
+
+static void unlink_slab(PoolSlab **list, PoolSlab *slab) {
+    if (slab->prev)
+        slab->prev->next = slab->next;
+    else
+        *list = slab->next;
+    if (slab->next)
+        slab->next->prev = slab->prev;
+}
+
+static PoolSlab *new_slab(Pool *pool) {
+    PoolSlab *slab = virtalloc_aligned_alloc_impl(pool->allocator, POOL_SLAB_SIZE, POOL_SLAB_SIZE);
+    if (!slab)
+        return NULL;
+    slab->pool = pool;
+    slab->free_list = NULL;
+    slab->unused_start = (void *) slab + pool->first_object_offset;
+    slab->num_allocated = 0;
+    push_slab(&pool->partial_slabs, slab);
+    pool->num_slabs++;
+    return slab;
+}
+
+void *pool_alloc(Pool *pool) {
+    PoolSlab *slab = pool->partial_slabs;
+    if (!slab && !(slab = new_slab(pool)))
+        return NULL;
+    void *p;
+    if (slab->free_list) {
+        p = slab->free_list;
+        slab->free_list = *(void **) p;
+    } else {
+        p = slab->unused_start;
+        slab->unused_start += pool->object_stride;
+    }
+    if (++slab->num_allocated == pool->objects_per_slab) {
+        unlink_slab(&pool->partial_slabs, slab);
+        push_slab(&pool->full_slabs, slab);
+    }
+    return p;
+}
+
+void pool_free(Pool *pool, void *p) {
+    if (!p)
+        return;
+    PoolSlab *slab = (PoolSlab *) align_down((size_t) p, POOL_SLAB_SIZE);
+    assert_external(slab->pool == pool && "pointer was not allocated from this pool");
+    assert_external((size_t) (p - (void *) slab) >= pool->first_object_offset
+        && (size_t) (p - (void *) slab - pool->first_object_offset) % pool->object_stride == 0
+        && p < slab->unused_start && "pointer is not an object of this pool");
+    if (slab->num_allocated-- == pool->objects_per_slab) {
+        unlink_slab(&pool->full_slabs, slab);
+        push_slab(&pool->partial_slabs, slab);
+    }
+    if (!slab->num_allocated && (slab->prev || slab->next)) {
+        // the slab is empty and another slab can serve the next allocations
+        unlink_slab(&pool->partial_slabs, slab);
+        virtalloc_free_impl(pool->allocator, slab);
+        pool->num_slabs--;
+        return;
+    }
+    *(void **) p = slab->free_list;
+    slab->free_list = p;
+}
+
+static void free_slab_list(Pool *pool, PoolSlab *slab) {
+    while (slab) {
+        PoolSlab *next = slab->next;
+        virtalloc_free_impl(pool->allocator, slab);
+        slab = next;
+    }
+}
+
+void pool_destroy(Pool *pool) {
+    free_slab_list(pool, pool->partial_slabs);
+    free_slab_list(pool, pool->full_slabs);
+    virtalloc_free_impl(pool->allocator, pool);
+}
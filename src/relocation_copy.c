@@ -0,0 +1,80 @@
+#include <stddef.h>
+#include <string.h>
+#include "virtalloc/relocation_copy.h"
+#include "virtalloc/allocator_settings.h"
+#include "virtalloc/math_utils.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// each iteration of the copy loops moves 128 bytes (4 AVX2 or 8 SSE2 vectors) and stores them to an aligned dst
+#define NON_TEMPORAL_COPY_BLOCK_SIZE 128
+
+__attribute__((target("avx2")))
+static void non_temporal_copy_avx2(void *dst, const void *src, const size_t size) {
+    __m256i *d = dst;
+    const __m256i *s = src;
+    for (size_t i = 0; i < size / sizeof(__m256i); i += 4) {
+        const __m256i a = _mm256_loadu_si256(s + i);
+        const __m256i b = _mm256_loadu_si256(s + i + 1);
+        const __m256i c = _mm256_loadu_si256(s + i + 2);
+        const __m256i e = _mm256_loadu_si256(s + i + 3);
+        _mm256_stream_si256(d + i, a);
+        _mm256_stream_si256(d + i + 1, b);
+        _mm256_stream_si256(d + i + 2, c);
+        _mm256_stream_si256(d + i + 3, e);
+    }
+}
+
+__attribute__((target("sse2")))
+static void non_temporal_copy_sse2(void *dst, const void *src, const size_t size) {
+    __m128i *d = dst;
+    const __m128i *s = src;
+    for (size_t i = 0; i < size / sizeof(__m128i); i += 8) {
+        for (size_t j = 0; j < 8; j++)
+            _mm_stream_si128(d + i + j, _mm_loadu_si128(s + i + j));
+    }
+}
+
+void non_temporal_copy(void *dst, const void *src, const size_t size) {
+    // cached after the first call, so this is cheap
+    static int has_avx2 = -1;
+    int avx2 = __atomic_load_n(&has_avx2, __ATOMIC_RELAXED);
+    if (avx2 < 0) {
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2") != 0;
+        __atomic_store_n(&has_avx2, avx2, __ATOMIC_RELAXED);
+    }
+    // the stores must be aligned, so the unaligned head and the tail that doesn't fill a whole block are copied by memcpy
+    const size_t head = align_to((size_t) dst, NON_TEMPORAL_COPY_BLOCK_SIZE) - (size_t) dst;
+    if (size < head + NON_TEMPORAL_COPY_BLOCK_SIZE) {
+        // not a single aligned block to stream
+        memcpy(dst, src, size);
+        return;
+    }
+    const size_t body = align_down(size - head, NON_TEMPORAL_COPY_BLOCK_SIZE);
+    memcpy(dst, src, head);
+    if (avx2)
+        non_temporal_copy_avx2(dst + head, src + head, body);
+    else
+        non_temporal_copy_sse2(dst + head, src + head, body);
+    // non-temporal stores are weakly ordered, they must be visible before the old memory is freed and reused
+    _mm_sfence();
+    memcpy(dst + head + body, src + head + body, size - head - body);
+}
+
+#else
+
+void non_temporal_copy(void *dst, const void *src, const size_t size) {
+    memcpy(dst, src, size);
+}
+
+#endif
+
+void relocation_copy(void *dst, const void *src, const size_t size) {
+    if (size < NON_TEMPORAL_COPY_MIN_SIZE)
+        memcpy(dst, src, size);
+    else
+        non_temporal_copy(dst, src, size);
+}
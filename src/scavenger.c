@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include "virtalloc/scavenger.h"
+#include "virtalloc/allocator_impl.h"
+#include "virtalloc/helper_macros.h"
+
+#ifdef _WIN32
+
+// the scavenger is built on pthreads, so on windows, trimming and refilling only happen synchronously
+
+int start_scavenger(Allocator *allocator, const unsigned interval_ms, const size_t keep_resident_bytes,
+                    const size_t reserve_bytes) {
+    (void) allocator;
+    (void) interval_ms;
+    (void) keep_resident_bytes;
+    (void) reserve_bytes;
+    return 0;
+}
+
+void stop_scavenger(Allocator *allocator) {
+    (void) allocator;
+}
+
+#else
+
+#include <pthread.h>
+#include <time.h>
+
+typedef struct Scavenger {
+    Allocator *allocator;
+    pthread_t thread;
+    /// protects stop and is used with wake to sleep between passes
+    pthread_mutex_t mutex;
+    /// signalled to wake the scavenger up early when it should stop
+    pthread_cond_t wake;
+    int stop;
+    unsigned interval_ms;
+    size_t keep_resident_bytes;
+    size_t reserve_bytes;
+} Scavenger;
+
+static struct timespec get_wakeup_time(const unsigned interval_ms) {
+    struct timespec t;
+    clock_gettime(CLOCK_REALTIME, &t);
+    t.tv_sec += interval_ms / 1000;
+    t.tv_nsec += (long) (interval_ms % 1000) * 1000000;
+    if (t.tv_nsec >= 1000000000) {
+        t.tv_sec++;
+        t.tv_nsec -= 1000000000;
+    }
+    return t;
+}
+
+static void *run_scavenger(void *p) {
+    Scavenger *scavenger = p;
+    pthread_mutex_lock(&scavenger->mutex);
+    while (!scavenger->stop) {
+        const struct timespec wakeup_time = get_wakeup_time(scavenger->interval_ms);
+        while (!scavenger->stop && pthread_cond_timedwait(&scavenger->wake, &scavenger->mutex, &wakeup_time) == 0) {
+        }
+        if (scavenger->stop)
+            break;
+        // the allocator locks are taken by the passes themselves, so mallocs and frees are only blocked briefly
+        pthread_mutex_unlock(&scavenger->mutex);
+        if (scavenger->reserve_bytes)
+            refill_gpa_reserve(scavenger->allocator, scavenger->reserve_bytes);
+        // regions are only decommitted, not released, so that the reserve that was just acquired stays around
+        virtalloc_trim_impl(scavenger->allocator, scavenger->keep_resident_bytes, 0);
+        pthread_mutex_lock(&scavenger->mutex);
+    }
+    pthread_mutex_unlock(&scavenger->mutex);
+    return NULL;
+}
+
+int start_scavenger(Allocator *allocator, const unsigned interval_ms, const size_t keep_resident_bytes,
+                    const size_t reserve_bytes) {
+    // the scavenger works concurrently with the user's threads, so it needs the allocator locks
+    if (allocator->scavenger || allocator->assume_thread_safe_usage)
+        return 0;
+    Scavenger *scavenger = malloc(sizeof(Scavenger));
+    assert_external(scavenger && "failed to allocate scavenger");
+    *scavenger = (Scavenger){
+        .allocator = allocator, .stop = 0, .interval_ms = interval_ms, .keep_resident_bytes = keep_resident_bytes,
+        .reserve_bytes = reserve_bytes
+    };
+    pthread_mutex_init(&scavenger->mutex, NULL);
+    pthread_cond_init(&scavenger->wake, NULL);
+    if (pthread_create(&scavenger->thread, NULL, run_scavenger, scavenger) != 0) {
+        pthread_cond_destroy(&scavenger->wake);
+        pthread_mutex_destroy(&scavenger->mutex);
+        free(scavenger);
+        return 0;
+    }
+    allocator->scavenger = scavenger;
+    return 1;
+}
+
+void stop_scavenger(Allocator *allocator) {
+    Scavenger *scavenger = allocator->scavenger;
+    if (!scavenger)
+        return;
+    pthread_mutex_lock(&scavenger->mutex);
+    scavenger->stop = 1;
+    pthread_cond_signal(&scavenger->wake);
+    pthread_mutex_unlock(&scavenger->mutex);
+    pthread_join(scavenger->thread, NULL);
+    pthread_cond_destroy(&scavenger->wake);
+    pthread_mutex_destroy(&scavenger->mutex);
+    free(scavenger);
+    allocator->scavenger = NULL;
+}
+
+#endif
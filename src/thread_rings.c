@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include "virtalloc/thread_rings.h"
+#include "virtalloc/allocator_settings.h"
+#include "virtalloc/helper_macros.h"
+
+#ifdef _WIN32
+
+// there is no portable way to get notified when a thread exits on windows, so per-thread rings are not supported and
+// all threads use the shared SMA
+
+ThreadRing *get_thread_ring(Allocator *allocator) {
+    (void) allocator;
+    return NULL;
+}
+
+int adopt_abandoned_ring(Allocator *allocator, ThreadRing *ring) {
+    (void) allocator;
+    (void) ring;
+    return 0;
+}
+
+void forget_thread_rings_of(const Allocator *allocator) {
+    (void) allocator;
+}
+
+#else
+
+#include <pthread.h>
+
+typedef struct ThreadRingCacheEntry {
+    /// the allocator the ring belongs to or NULL if the entry is unused. Only accessed atomically.
+    const Allocator *allocator;
+    ThreadRing *ring;
+} ThreadRingCacheEntry;
+
+/// everything a thread needs to remember about the rings it owns. All thread states are kept in a registry so that
+/// destroying an allocator can make every thread forget its rings of that allocator.
+typedef struct ThreadState {
+    ThreadRingCacheEntry entries[THREAD_RING_CACHE_SIZE];
+    struct ThreadState *prev;
+    struct ThreadState *next;
+} ThreadState;
+
+static pthread_once_t thread_state_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_state_key;
+/// protects the registry and all modifications of thread state entries
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadState *registry;
+static __thread ThreadState *thread_state;
+
+/// called when a thread exits: abandons all rings of the thread so other threads can adopt them
+static void release_thread_state(void *p) {
+    ThreadState *state = p;
+    pthread_mutex_lock(&registry_lock);
+    for (size_t i = 0; i < THREAD_RING_CACHE_SIZE; i++)
+        if (state->entries[i].allocator)
+            __atomic_store_n(&state->entries[i].ring->owner, NULL, __ATOMIC_RELEASE);
+    if (state->prev)
+        state->prev->next = state->next;
+    else
+        registry = state->next;
+    if (state->next)
+        state->next->prev = state->prev;
+    pthread_mutex_unlock(&registry_lock);
+    thread_state = NULL;
+    free(state);
+}
+
+static void create_thread_state_key(void) {
+    const int err = pthread_key_create(&thread_state_key, release_thread_state);
+    assert_external(!err && "failed to create the thread state key for per-thread rings");
+}
+
+static ThreadState *get_thread_state(void) {
+    if (thread_state)
+        return thread_state;
+    pthread_once(&thread_state_key_once, create_thread_state_key);
+    ThreadState *state = calloc(1, sizeof(ThreadState));
+    if (!state)
+        return NULL;
+    pthread_mutex_lock(&registry_lock);
+    state->next = registry;
+    if (registry)
+        registry->prev = state;
+    registry = state;
+    pthread_mutex_unlock(&registry_lock);
+    pthread_setspecific(thread_state_key, state);
+    thread_state = state;
+    return state;
+}
+
+ThreadRing *get_thread_ring(Allocator *allocator) {
+    // fast path: the thread already owns a ring of this allocator
+    const ThreadState *cached_state = thread_state;
+    if (cached_state)
+        for (size_t i = 0; i < THREAD_RING_CACHE_SIZE; i++)
+            if (__atomic_load_n(&cached_state->entries[i].allocator, __ATOMIC_ACQUIRE) == allocator)
+                return cached_state->entries[i].ring;
+
+    // slow path: acquire an unowned ring
+    ThreadState *state = get_thread_state();
+    if (!state)
+        return NULL;
+    ThreadRing *ring = NULL;
+    pthread_mutex_lock(&registry_lock);
+    ThreadRingCacheEntry *entry = NULL;
+    for (size_t i = 0; i < THREAD_RING_CACHE_SIZE && !entry; i++)
+        if (!state->entries[i].allocator)
+            entry = &state->entries[i];
+    for (size_t i = 0; i < allocator->num_thread_rings && entry && !ring; i++) {
+        void *expected = NULL;
+        if (__atomic_compare_exchange_n(&allocator->thread_rings[i].owner, &expected, state, 0, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+            ring = &allocator->thread_rings[i];
+    }
+    if (ring) {
+        entry->ring = ring;
+        __atomic_store_n(&entry->allocator, allocator, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&registry_lock);
+    return ring;
+}
+
+int adopt_abandoned_ring(Allocator *allocator, ThreadRing *ring) {
+    void *const owner = __atomic_load_n(&ring->owner, __ATOMIC_RELAXED);
+    assert_internal(owner && "illegal usage: only the owner of a ring may adopt other rings into it");
+    for (size_t i = 0; i < allocator->num_thread_rings; i++) {
+        ThreadRing *other = &allocator->thread_rings[i];
+        void *expected = NULL;
+        if (other == ring || __atomic_load_n(&other->owner, __ATOMIC_RELAXED)
+            || !__atomic_compare_exchange_n(&other->owner, &expected, owner, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            continue;
+        if (!other->sma.first_slot) {
+            // nothing to adopt, the ring never got any memory
+            __atomic_store_n(&other->owner, NULL, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        // splice the chunks of the other ring into this one (the last link of each ring leads to its first slot)
+        if (ring->sma.first_slot) {
+            *(void **) ring->sma.last_slot = other->sma.first_slot;
+            *(void **) other->sma.last_slot = ring->sma.first_slot;
+        } else {
+            ring->sma.first_slot = other->sma.first_slot;
+        }
+        ring->sma.last_slot = other->sma.last_slot;
+        // continue searching in the adopted chunks because they most likely have free slots
+        ring->sma.rr_slot = other->sma.first_slot;
+
+        other->sma.first_slot = NULL;
+        other->sma.last_slot = NULL;
+        other->sma.rr_slot = NULL;
+        __atomic_store_n(&other->owner, NULL, __ATOMIC_RELEASE);
+        return 1;
+    }
+    return 0;
+}
+
+void forget_thread_rings_of(const Allocator *allocator) {
+    pthread_mutex_lock(&registry_lock);
+    for (ThreadState *state = registry; state; state = state->next)
+        for (size_t i = 0; i < THREAD_RING_CACHE_SIZE; i++)
+            if (__atomic_load_n(&state->entries[i].allocator, __ATOMIC_RELAXED) == allocator)
+                __atomic_store_n(&state->entries[i].allocator, NULL, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&registry_lock);
+}
+
+#endif
@@ -1,14 +1,57 @@
 #include "virtalloc/allocator.h"
 #include "virtalloc/cross_platform_lock.h"
 
+void lock_allocator_parts(Allocator *allocator, const int parts) {
+    // the locks are recursive, so nested allocator operations within a thread can simply lock again. Every thread must
+    // take them in the same order though, otherwise two threads could deadlock each other.
+    if (parts & ALLOCATOR_PART_SMA)
+        lock(&allocator->sma_lock);
+    if (parts & ALLOCATOR_PART_GPA) {
+        lock(&allocator->gpa_lock);
+        allocator->gpa_lock_depth++;
+    }
+    if (parts & ALLOCATOR_PART_BACKING) {
+        lock(&allocator->backing_lock);
+        allocator->backing_lock_depth++;
+    }
+}
+
+void unlock_allocator_parts(Allocator *allocator, const int parts) {
+    if (parts & ALLOCATOR_PART_BACKING) {
+        allocator->backing_lock_depth--;
+        unlock(&allocator->backing_lock);
+    }
+    if (parts & ALLOCATOR_PART_GPA) {
+        allocator->gpa_lock_depth--;
+        unlock(&allocator->gpa_lock);
+    }
+    if (parts & ALLOCATOR_PART_SMA)
+        unlock(&allocator->sma_lock);
+}
+
+int try_lock_allocator_parts(Allocator *allocator, const int parts) {
+    // trying never waits, so the lock order does not matter for deadlocks, but it is kept for consistency
+    if ((parts & ALLOCATOR_PART_SMA) && !try_lock(&allocator->sma_lock))
+        return 0;
+    if ((parts & ALLOCATOR_PART_GPA) && !try_lock(&allocator->gpa_lock)) {
+        unlock_allocator_parts(allocator, parts & ALLOCATOR_PART_SMA);
+        return 0;
+    }
+    if (parts & ALLOCATOR_PART_GPA)
+        allocator->gpa_lock_depth++;
+    if ((parts & ALLOCATOR_PART_BACKING) && !try_lock(&allocator->backing_lock)) {
+        unlock_allocator_parts(allocator, parts & (ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA));
+        return 0;
+    }
+    if (parts & ALLOCATOR_PART_BACKING)
+        allocator->backing_lock_depth++;
+    return 1;
+}
+
 void lock_virtual_allocator(Allocator *allocator) {
-    if (!allocator->intra_thread_lock_count)
-        lock(&allocator->lock);
-    allocator->intra_thread_lock_count++;
+    lock_allocator_parts(allocator, ALLOCATOR_PART_ALL);
 }
 
 void unlock_virtual_allocator(Allocator *allocator) {
-    allocator->intra_thread_lock_count--;
-    if (!allocator->intra_thread_lock_count)
-        unlock(&allocator->lock);
+    unlock_allocator_parts(allocator, ALLOCATOR_PART_ALL);
 }
@@ -3,6 +3,7 @@
 #include <memory.h>
 #include <assert.h>
 #include <stdio.h>
+#include <errno.h>
 #include "virtalloc.h"
 #include "virtalloc/allocator_impl.h"
 #include "virtalloc/gp_memory_slot_meta.h"
@@ -12,6 +13,14 @@
 #include "virtalloc/small_rr_memory_slot_meta.h"
 #include "virtalloc/helper_macros.h"
 #include "virtalloc/math_utils.h"
+#include "virtalloc/page_map.h"
+#include "virtalloc/exploration_tuner.h"
+#include "virtalloc/thread_rings.h"
+#include "virtalloc/scavenger.h"
+#include "virtalloc/early_release_cache.h"
+#include "virtalloc/os_memory.h"
+#include "virtalloc/arena.h"
+#include "virtalloc/pool.h"
 
 static size_t get_padding_lines_impl(const size_t allocation_size) {
     if (allocation_size < MIN_SIZE_FOR_SAFETY_PADDING)
@@ -29,11 +38,21 @@ static size_t get_min_size_for_early_release_from_flags(const int flags) {
                            : EARLY_RELEASE_SIZE_NORMAL;
 }
 
+static size_t get_gpa_alignment_from_flags(const int flags) {
+    const size_t alignment = flags & VIRTALLOC_FLAG_VA_GPA_ALIGN_16
+                                 ? 16
+                                 : flags & VIRTALLOC_FLAG_VA_GPA_ALIGN_32
+                                       ? 32
+                                       : LARGE_ALLOCATION_ALIGN;
+    return min(max(alignment, MIN_GPA_ALIGN), LARGE_ALLOCATION_ALIGN);
+}
+
 static vap_t new_virtual_allocator_from_impl(size_t size, char memory[static size], const int flags,
                                              const int memory_is_owned) {
     int disable_buckets = (flags & VIRTALLOC_FLAG_VA_DISABLE_BUCKETS) != 0;
     const size_t min_size_for_early_release = get_min_size_for_early_release_from_flags(flags);
-    const size_t num_buckets = disable_buckets ? 1 : min_size_for_early_release / LARGE_ALLOCATION_ALIGN;
+    const size_t gpa_alignment = get_gpa_alignment_from_flags(flags);
+    const size_t num_buckets = disable_buckets ? 1 : min_size_for_early_release / gpa_alignment;
     const size_t rounded_num_buckets = round_to_power_of_2(num_buckets);
 
     const size_t right_adjustment = (LARGE_ALLOCATION_ALIGN - (size_t) memory % LARGE_ALLOCATION_ALIGN) %
@@ -41,13 +60,12 @@ static vap_t new_virtual_allocator_from_impl(size_t size, char memory[static siz
     memory += right_adjustment;
     size -= right_adjustment;
 
+    const size_t num_thread_rings = flags & VIRTALLOC_FLAG_VA_PER_THREAD_SMA ? NUM_THREAD_RINGS : 0;
     if (size < sizeof(Allocator) + num_buckets * sizeof(size_t) + num_buckets * sizeof(void *) + (
-            2 * rounded_num_buckets - 1) * sizeof(GPBucketTreeNode))
+            2 * rounded_num_buckets - 1) * sizeof(GPBucketTreeNode) + num_thread_rings * sizeof(ThreadRing)
+        + LARGE_ALLOCATION_ALIGN)
         return NULL;
 
-    ThreadLock tl;
-    init_lock(&tl);
-
     int bucket_strat = disable_buckets
                            ? NO_BUCKETS
                            : (flags & VIRTALLOC_FLAG_VA_BUCKET_TREE) != 0
@@ -61,21 +79,25 @@ static vap_t new_virtual_allocator_from_impl(size_t size, char memory[static siz
         "you must explicitly select a bucket strategy when creating an allocator - passing VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS does that for you. Have you masked out the bucket strategy from it or passed 0 for `flags` instead?");
 
     Allocator va = {
-        .lock = tl,
         .gpa = {
-            .max_slot_checks_before_oom = (size_t) -1, .first_slot = NULL,
+            .max_slot_checks_before_oom = (size_t) -1, .first_slot = NULL, .alignment = gpa_alignment,
             .num_buckets = num_buckets, .rounded_num_buckets_pow_2 = rounded_num_buckets, .bucket_tree = NULL,
-            .min_size_for_early_release = min_size_for_early_release, .bucket_sizes = NULL, .bucket_values = NULL
+            .min_size_for_early_release = min_size_for_early_release,
+            .max_dynamic_early_release_size = flags & VIRTALLOC_FLAG_VA_DYNAMIC_EARLY_RELEASE
+                                                  ? DYNAMIC_EARLY_RELEASE_MAX_SIZE
+                                                  : 0,
+            .bucket_sizes = NULL, .bucket_values = NULL,
+            .tuner = {0}
         },
         .sma = {
             .max_slot_checks_before_oom = (size_t) DEFAULT_EXPLORATION_STEPS_BEFORE_RR_OOM, .first_slot = NULL,
-            .last_slot = NULL, .rr_slot = NULL
+            .last_slot = NULL, .rr_slot = NULL, .tuner = {0}
         },
         .malloc = virtalloc_malloc_impl, .free = virtalloc_free_impl, .realloc = virtalloc_realloc_impl,
         .gpa_add_new_memory = virtalloc_gpa_add_new_memory_impl,
         .sma_add_new_memory = virtalloc_sma_add_new_memory_impl, .release_memory = NULL, .request_new_memory = NULL,
         .pre_alloc_op = virtalloc_pre_op_callback_impl, .post_alloc_op = virtalloc_post_op_callback_impl,
-        .intra_thread_lock_count = 0,
+        .gpa_lock_depth = 0, .backing_lock_depth = 0, .deferred_gpa_frees = NULL, .deferred_backing_frees = NULL,
         .steps_per_checksum_check = flags & VIRTALLOC_FLAG_VA_DENSE_CHECKSUM_CHECKS ? 1 : STEPS_PER_CHECKSUM_CHECK,
         .memory_pointer_right_adjustment = right_adjustment,
         .get_gpa_padding_lines = flags & VIRTALLOC_FLAG_VA_HAS_SAFETY_PADDING_LINE ? get_padding_lines_impl : NULL,
@@ -86,8 +108,21 @@ static vap_t new_virtual_allocator_from_impl(size_t size, char memory[static siz
         .no_rr_allocator = (flags & VIRTALLOC_FLAG_VA_NO_RR_ALLOCATOR) != 0, .block_logging = 0,
         .sma_request_mem_from_gpa = (flags & VIRTALLOC_FLAG_VA_SMA_REQUEST_MEM_FROM_GPA) != 0,
         .debug_corruption_checks = (flags & VIRTALLOC_FLAG_VA_HEAVY_DEBUG_CORRUPTION_CHECKS) != 0,
+        .use_page_map = (flags & VIRTALLOC_FLAG_VA_PAGE_MAP_CLASSIFICATION) != 0,
+        .per_thread_sma = num_thread_rings != 0 && (flags & VIRTALLOC_FLAG_VA_NO_RR_ALLOCATOR) == 0,
+        .thread_rings = NULL, .num_thread_rings = 0, .reserved_end = NULL, .committed_end = NULL, .can_decommit = 0,
+        .auto_trim = 0, .trusted_free = (flags & VIRTALLOC_FLAG_VA_TRUSTED_FREE) != 0, .scavenger = NULL,
+        .early_release_blocks = NULL, .num_early_release_blocks = 0, .early_release_bytes = 0,
+        .num_reallocs_grown_forwards = 0, .num_reallocs_grown_backwards = 0, .num_reallocs_relocated = 0,
+        .early_release_cache = {
+            .max_bytes = flags & VIRTALLOC_FLAG_VA_EARLY_RELEASE_CACHE ? EARLY_RELEASE_CACHE_MAX_BYTES : 0
+        },
         .bucket_strategy = bucket_strat
     };
+    if (flags & VIRTALLOC_FLAG_VA_ADAPTIVE_EXPLORATION) {
+        exploration_tuner_enable(&va.gpa.tuner, &va.gpa.max_slot_checks_before_oom, DEFAULT_EXPLORATION_TARGET_PROBES);
+        exploration_tuner_enable(&va.sma.tuner, &va.sma.max_slot_checks_before_oom, DEFAULT_EXPLORATION_TARGET_PROBES);
+    }
     size_t mem_offset = sizeof(Allocator);
 
     // bucket sizes
@@ -105,20 +140,39 @@ static vap_t new_virtual_allocator_from_impl(size_t size, char memory[static siz
         mem_offset += n_tree_nodes * sizeof(GPBucketTreeNode);
     }
 
+    // per-thread rings (cache line aligned so that threads don't share cache lines)
+    if (va.per_thread_sma) {
+        mem_offset = align_to(mem_offset, LARGE_ALLOCATION_ALIGN);
+        va.thread_rings = (ThreadRing *) &memory[mem_offset];
+        va.num_thread_rings = num_thread_rings;
+        mem_offset += va.num_thread_rings * sizeof(ThreadRing);
+    }
+
     // first slot
     mem_offset = align_to(mem_offset + sizeof(GPMemorySlotMeta), LARGE_ALLOCATION_ALIGN);
+    size_t heap_end = size;
+    if (va.use_page_map) {
+        // the first slot must cover whole pages only, so its meta starts on a page boundary and its data ends on one
+        mem_offset = align_to((size_t) memory + mem_offset - sizeof(GPMemorySlotMeta), PAGE_MAP_PAGE_SIZE)
+                     + sizeof(GPMemorySlotMeta) - (size_t) memory;
+        heap_end = align_down((size_t) memory + size, PAGE_MAP_PAGE_SIZE) - (size_t) memory;
+    }
     va.gpa.first_slot = &memory[mem_offset];
-    const size_t remaining_slot_size = size < mem_offset ? 0 : (void *) memory + size - va.gpa.first_slot;
+    const size_t remaining_slot_size = heap_end < mem_offset ? 0 : (void *) memory + heap_end - va.gpa.first_slot;
     if (remaining_slot_size < MIN_LARGE_ALLOCATION_SIZE)
         va.gpa.first_slot = NULL;
 
     // write allocator struct to mem
     *(Allocator *) memory = va;
+    Allocator *alloc = (Allocator *) memory;
+    init_lock(&alloc->sma_lock);
+    init_lock(&alloc->gpa_lock);
+    init_lock(&alloc->backing_lock);
 
     // initialize bucket sizes
     for (size_t i = 0; i < va.gpa.num_buckets; i++)
         // this initializes them linearly with a step size of ALIGN which should lead to O(1) malloc/free
-        va.gpa.bucket_sizes[i] = MIN_LARGE_ALLOCATION_SIZE + i * LARGE_ALLOCATION_ALIGN;
+        va.gpa.bucket_sizes[i] = MIN_LARGE_ALLOCATION_SIZE + i * va.gpa.alignment;
 
     // another approach for initializing:
     // double current_bucket_size = MIN_LARGE_ALLOCATION_SIZE;
@@ -131,6 +185,10 @@ static vap_t new_virtual_allocator_from_impl(size_t size, char memory[static siz
     // initialize bucket values
     memset(va.gpa.bucket_values, 0, va.gpa.num_buckets * sizeof(void *));
 
+    // initialize the per-thread rings as empty, unowned copies of the SMA
+    for (size_t i = 0; i < va.num_thread_rings; i++)
+        va.thread_rings[i] = (ThreadRing){.sma = va.sma, .owner = NULL};
+
     if (va.bucket_strategy == BUCKET_TREE) {
         // initialize bucket tree
         size_t n_tree_levels = ilog2l(va.gpa.num_buckets) + 1;
@@ -152,10 +210,13 @@ static vap_t new_virtual_allocator_from_impl(size_t size, char memory[static siz
         const GPMemorySlotMeta first_slot_meta_content = {
             .checksum = 0, .size = remaining_slot_size, .data = va.gpa.first_slot, .next = va.gpa.first_slot,
             .prev = va.gpa.first_slot, .next_bigger_free = NULL, .next_smaller_free = NULL, .time_to_checksum_check = 0,
-            .memory_pointer_right_adjustment = 0, .is_free = 1, .memory_is_owned = 0, .__bit_padding1 = 0,
-            .__padding = {0}, .__bit_padding2 = 0, .meta_type = GP_META_TYPE_SLOT
+            .memory_pointer_right_adjustment = 0, .is_free = 1, .memory_is_owned = 0, .is_decommitted = 0,
+            .__bit_padding1 = 0, .growth_streak = 0, .unrequested_size = 0, .__padding = {0}, .__bit_padding2 = 0,
+            .meta_type = GP_META_TYPE_SLOT
         };
         *first_slot_meta_ptr = first_slot_meta_content;
+        if (va.use_page_map)
+            page_map_set_range(first_slot_meta_ptr, sizeof(GPMemorySlotMeta) + remaining_slot_size, GP_META_TYPE_SLOT);
         insert_into_sorted_free_list((Allocator *) memory, first_slot_meta_ptr);
     }
 
@@ -166,14 +227,76 @@ vap_t virtalloc_new_allocator_in(const size_t size, char memory[static size], co
     return new_virtual_allocator_from_impl(size, memory, flags, 0);
 }
 
+/// marks the initial free slot of an allocator whose memory was freshly mapped by the OS as zero-filled
+static void mark_first_slot_zero_filled(Allocator *alloc) {
+    if (!alloc->gpa.first_slot)
+        return;
+    GPMemorySlotMeta *meta = get_meta(alloc, alloc->gpa.first_slot, EXPECT_IS_FREE);
+    meta->is_decommitted = 1;
+    refresh_checksum_of(alloc, meta);
+}
+
 vap_t virtalloc_new_allocator(size_t size, const int flags) {
     int disable_buckets = (flags & VIRTALLOC_FLAG_VA_DISABLE_BUCKETS) != 0;
     const size_t min_size_for_early_release = get_min_size_for_early_release_from_flags(flags);
-    const size_t num_buckets = disable_buckets ? 1 : min_size_for_early_release / LARGE_ALLOCATION_ALIGN;
+    const size_t num_buckets = disable_buckets ? 1 : min_size_for_early_release / get_gpa_alignment_from_flags(flags);
     const size_t rounded_num_buckets = round_to_power_of_2(num_buckets);
 
     size += sizeof(Allocator) + num_buckets * sizeof(size_t) + num_buckets * sizeof(void *) + (
-        2 * rounded_num_buckets - 1) * sizeof(GPBucketTreeNode) + LARGE_ALLOCATION_ALIGN;
+        2 * rounded_num_buckets - 1) * sizeof(GPBucketTreeNode) + 2 * LARGE_ALLOCATION_ALIGN;
+    if (flags & VIRTALLOC_FLAG_VA_PER_THREAD_SMA)
+        size += NUM_THREAD_RINGS * sizeof(ThreadRing);
+    if (flags & VIRTALLOC_FLAG_VA_PAGE_MAP_CLASSIFICATION)
+        // the first slot is shrunk to whole pages, which may cost up to one page at either end
+        size += 2 * PAGE_MAP_PAGE_SIZE;
+
+    if (flags & VIRTALLOC_FLAG_VA_RESERVE_ADDRESS_SPACE) {
+        // the heap lives at the start of one big reservation and grows by committing more of it. Early release blocks
+        // are still mapped separately so they can be returned to the OS individually.
+        void *reserved_end;
+        char *memory = os_reserve_memory(max(size, RESERVED_ADDRESS_SPACE_SIZE), size, &reserved_end);
+        if (!memory)
+            return NULL;
+        size = *(size_t *) memory;
+        Allocator *alloc = new_virtual_allocator_from_impl(size, memory, flags, 1);
+        if (!alloc) {
+            os_release_memory(memory);
+            return NULL;
+        }
+        alloc->reserved_end = reserved_end;
+        alloc->committed_end = memory + size;
+        alloc->can_decommit = 1;
+        mark_first_slot_zero_filled(alloc);
+        alloc->auto_trim = (flags & VIRTALLOC_FLAG_VA_AUTO_TRIM) != 0;
+        // releasing the allocator unmaps the entire reservation
+        virtalloc_set_release_mechanism(alloc, os_release_memory);
+        virtalloc_set_request_mechanism(alloc, os_request_memory);
+        return alloc;
+    }
+
+    if (flags & (VIRTALLOC_FLAG_VA_OS_BACKEND | VIRTALLOC_FLAG_VA_HUGE_PAGES)) {
+        // the allocator's own memory and all memory it requests later come directly from the OS
+        void *(*request_memory)(size_t) = flags & VIRTALLOC_FLAG_VA_HUGE_PAGES
+                                              ? os_request_huge_page_memory
+                                              : os_request_memory;
+        char *memory = request_memory(size);
+        if (!memory)
+            return NULL;
+        // the mapping is rounded up to whole pages, so the allocator can use all of it
+        size = *(size_t *) memory;
+        Allocator *alloc = new_virtual_allocator_from_impl(size, memory, flags, 1);
+        if (!alloc) {
+            os_release_memory(memory);
+            return NULL;
+        }
+        alloc->can_decommit = 1;
+        mark_first_slot_zero_filled(alloc);
+        alloc->auto_trim = (flags & VIRTALLOC_FLAG_VA_AUTO_TRIM) != 0;
+        virtalloc_set_release_mechanism(alloc, os_release_memory);
+        virtalloc_set_request_mechanism(alloc, request_memory);
+        return alloc;
+    }
+
     char *memory = malloc(size);
     if (!memory)
         return NULL;
@@ -185,9 +308,105 @@ vap_t virtalloc_new_allocator(size_t size, const int flags) {
     return alloc;
 }
 
+/// releases all early release blocks that are still allocated
+static void release_early_release_blocks(Allocator *alloc) {
+    GPEarlyReleaseMeta *meta = alloc->early_release_blocks;
+    while (meta) {
+        GPEarlyReleaseMeta *next_meta = meta->next_block;
+        if (alloc->use_page_map)
+            page_map_clear_range(meta, align_down((size_t) (meta + 1) + meta->size, PAGE_MAP_PAGE_SIZE)
+                                       - (size_t) meta);
+        if (alloc->release_memory)
+            alloc->release_memory(meta->data);
+        meta = next_meta;
+    }
+    alloc->early_release_blocks = NULL;
+}
+
+/// removes all chunks of an SMA ring from the process-wide page map
+static void unregister_sma_from_page_map(const SmallRRAllocator *sma) {
+    if (!sma->first_slot)
+        return;
+    // walk the ring chunk by chunk: every chunk ends in a link that leads to the first slot of the next chunk
+    void *chunk_first_slot = sma->first_slot;
+    do {
+        const SmallRRStartOfMemoryChunkMeta *mcm =
+                chunk_first_slot - sizeof(SmallRRMemorySlotMeta) - sizeof(SmallRRStartOfMemoryChunkMeta);
+        size_t chunk_size;
+        memmove(&chunk_size, &mcm->chunk_size_raw_bytes, sizeof(chunk_size));
+        page_map_clear_range(mcm, chunk_size);
+        void *slot = chunk_first_slot;
+        while (((SmallRRMemorySlotMeta *) (slot - sizeof(SmallRRMemorySlotMeta)))->meta_type != RR_META_TYPE_LINK)
+            slot += MAX_TINY_ALLOCATION_SIZE;
+        chunk_first_slot = *(void **) slot;
+    } while (chunk_first_slot != sma->first_slot);
+}
+
+/// removes all regions of the allocator from the process-wide page map
+static void unregister_from_page_map(Allocator *alloc) {
+    if (alloc->gpa.first_slot) {
+        // the slots of a region tile it exactly and regions are page aligned, so this clears exactly the region pages
+        const GPMemorySlotMeta *gpa_meta = get_meta(alloc, alloc->gpa.first_slot, NO_EXPECTATION);
+        int is_first_iter = 1;
+        while (gpa_meta->data != alloc->gpa.first_slot || is_first_iter) {
+            is_first_iter = 0;
+            page_map_clear_range(gpa_meta, sizeof(*gpa_meta) + gpa_meta->size);
+            gpa_meta = get_meta(alloc, gpa_meta->next, NO_EXPECTATION);
+        }
+    }
+
+    if (alloc->no_rr_allocator)
+        return;
+    unregister_sma_from_page_map(&alloc->sma);
+    for (size_t i = 0; i < alloc->num_thread_rings; i++)
+        unregister_sma_from_page_map(&alloc->thread_rings[i].sma);
+}
+
+/// calls the release callback on every chunk of an SMA ring that was requested using request_new_memory
+static void release_sma_memory(Allocator *alloc, const SmallRRAllocator *sma) {
+    int is_first_iter = 1;
+    void *starting_slot = sma->first_slot;
+    if (!starting_slot)
+        return;
+    void *slot = starting_slot;
+    void *next_to_dealloc = NULL;
+    while (slot != starting_slot || is_first_iter) {
+        is_first_iter = 0;
+        const SmallRRMemorySlotMeta *meta = slot - sizeof(SmallRRMemorySlotMeta);
+        if (meta->meta_type == RR_META_TYPE_LINK) {
+            void *next_slot = *(void **) slot;
+            if (next_to_dealloc)
+                alloc->release_memory(next_to_dealloc);
+            const SmallRRStartOfMemoryChunkMeta *mcm =
+                    next_slot - sizeof(SmallRRMemorySlotMeta) - sizeof(SmallRRStartOfMemoryChunkMeta);
+            next_to_dealloc = mcm->must_release_chunk_on_destroy
+                                  ? *(void **) &mcm->memory_chunk_ptr_raw_bytes
+                                  : NULL;
+            slot = next_slot;
+        } else {
+            assert_internal(meta->meta_type == RR_META_TYPE_SLOT && "unreachable");
+            slot = get_next_rr_slot(alloc, slot);
+        }
+    }
+    if (next_to_dealloc)
+        alloc->release_memory(next_to_dealloc);
+}
+
 void virtalloc_destroy_allocator(vap_t allocator) {
     Allocator *alloc = allocator;
+    // the scavenger must not touch the heap while it is being released
+    stop_scavenger(alloc);
+    if (alloc->per_thread_sma)
+        // threads must not keep pointers to rings of an allocator that no longer exists
+        forget_thread_rings_of(alloc);
+    // early release blocks on the deferred free stacks would be leaked otherwise
+    virtalloc_drain_deferred_frees_impl(alloc);
     lock_virtual_allocator(alloc);
+    // cached early release blocks are not part of the heap, so they must be released separately
+    early_release_cache_flush(alloc);
+
+    if (alloc->use_page_map)
+        unregister_from_page_map(alloc);
 
     if (!alloc->release_memory || alloc->release_only_allocator)
         goto finalize;
@@ -215,37 +434,18 @@ void virtalloc_destroy_allocator(vap_t allocator) {
     if (alloc->no_rr_allocator)
         goto finalize;
 
-    // release the RR allocator's memory
-    is_first_iter = 1;
-    starting_slot = alloc->sma.first_slot;
-    if (starting_slot) {
-        void *slot = starting_slot;
-        void *next_to_dealloc = NULL;
-        while (slot != starting_slot || is_first_iter) {
-            is_first_iter = 0;
-            const SmallRRMemorySlotMeta *meta = slot - sizeof(SmallRRMemorySlotMeta);
-            if (meta->meta_type == RR_META_TYPE_LINK) {
-                void *next_slot = *(void **) slot;
-                if (next_to_dealloc)
-                    alloc->release_memory(next_to_dealloc);
-                const SmallRRStartOfMemoryChunkMeta *mcm =
-                        next_slot - sizeof(SmallRRMemorySlotMeta) - sizeof(SmallRRStartOfMemoryChunkMeta);
-                next_to_dealloc = mcm->must_release_chunk_on_destroy
-                                      ? *(void **) &mcm->memory_chunk_ptr_raw_bytes
-                                      : NULL;
-                slot = next_slot;
-            } else {
-                assert_internal(meta->meta_type == RR_META_TYPE_SLOT && "unreachable");
-                slot = get_next_rr_slot(alloc, slot);
-            }
-        }
-        if (next_to_dealloc)
-            alloc->release_memory(next_to_dealloc);
-    }
+    // release the RR allocators' memory
+    release_sma_memory(alloc, &alloc->sma);
+    for (size_t i = 0; i < alloc->num_thread_rings; i++)
+        release_sma_memory(alloc, &alloc->thread_rings[i].sma);
 
 finalize:
+    // live early release blocks are released last because SMA chunks may have been carved out of them
+    release_early_release_blocks(alloc);
     unlock_virtual_allocator(alloc);
-    destroy_lock(&alloc->lock);
+    destroy_lock(&alloc->sma_lock);
+    destroy_lock(&alloc->gpa_lock);
+    destroy_lock(&alloc->backing_lock);
     if (alloc->release_memory && alloc->memory_is_owned)
         alloc->release_memory(allocator - alloc->memory_pointer_right_adjustment);
 }
@@ -255,11 +455,85 @@ void *virtalloc_realloc(vap_t allocator, void *p, const size_t size) {
     return alloc->realloc(alloc, p, size);
 }
 
+void *virtalloc_calloc(vap_t allocator, const size_t n, const size_t size) {
+    Allocator *alloc = allocator;
+    return virtalloc_calloc_impl(alloc, n, size);
+}
+
+void *virtalloc_aligned_alloc(vap_t allocator, const size_t alignment, const size_t size) {
+    Allocator *alloc = allocator;
+    return virtalloc_aligned_alloc_impl(alloc, alignment, size);
+}
+
+int virtalloc_posix_memalign(vap_t allocator, void **out, const size_t alignment, const size_t size) {
+    Allocator *alloc = allocator;
+    if (!alignment || alignment & (alignment - 1) || alignment % sizeof(void *))
+        return EINVAL;
+    void *p = virtalloc_aligned_alloc_impl(alloc, alignment, size);
+    if (!p)
+        return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+size_t virtalloc_usable_size(vap_t allocator, void *p) {
+    Allocator *alloc = allocator;
+    return virtalloc_usable_size_impl(alloc, p);
+}
+
+/// Grows the allocation at p to at least new_size bytes without moving it. Returns 1 on success and 0 (without changing
+/// anything) if the memory after the allocation is not free.
+int virtalloc_try_expand(vap_t allocator, void *p, const size_t new_size) {
+    Allocator *alloc = allocator;
+    return virtalloc_resize_in_place_impl(alloc, p, new_size, 0);
+}
+
+/// Shrinks the allocation at p to new_size bytes without moving it, giving the freed tail back to the allocator if it is
+/// big enough to be reused. Returns 0 if new_size is bigger than the allocation.
+int virtalloc_try_shrink(vap_t allocator, void *p, const size_t new_size) {
+    Allocator *alloc = allocator;
+    return virtalloc_resize_in_place_impl(alloc, p, new_size, 1);
+}
+
+void *virtalloc_malloc_at_least(vap_t allocator, const size_t size, size_t *actual_size) {
+    Allocator *alloc = allocator;
+    void *p = alloc->malloc(alloc, size, 0);
+    if (p && actual_size)
+        *actual_size = virtalloc_usable_size_impl(alloc, p);
+    return p;
+}
+
 void virtalloc_free(vap_t allocator, void *p) {
     Allocator *alloc = allocator;
     alloc->free(alloc, p);
 }
 
+void virtalloc_free_sized(vap_t allocator, void *p, const size_t size) {
+    Allocator *alloc = allocator;
+    virtalloc_free_sized_impl(alloc, p, size, 0);
+}
+
+/// Like virtalloc_free_sized, but the caller vouches for p being a live allocation of this allocator, so the forced
+/// checksum validation is skipped.
+void virtalloc_free_trusted(vap_t allocator, void *p, const size_t size) {
+    Allocator *alloc = allocator;
+    virtalloc_free_sized_impl(alloc, p, size, 1);
+}
+
+/// Never blocks. Returns VIRTALLOC_TRY_WOULD_BLOCK if another thread holds a lock the allocation may need, in which
+/// case *out is NULL and nothing was done.
+int virtalloc_try_malloc(vap_t allocator, const size_t size, void **out) {
+    Allocator *alloc = allocator;
+    return virtalloc_try_malloc_impl(alloc, size, out);
+}
+
+/// Never blocks. Returns VIRTALLOC_TRY_DEFERRED if another thread holds the lock required to free p, in which case p
+/// is freed by the next thread that releases that lock. Either way, p must not be used anymore.
+int virtalloc_try_free(vap_t allocator, void *p) {
+    Allocator *alloc = allocator;
+    return virtalloc_try_free_impl(alloc, p);
+}
+
 void *virtalloc_malloc(vap_t allocator, const size_t size) {
     Allocator *alloc = allocator;
     return alloc->malloc(alloc, size, 0);
@@ -277,6 +551,9 @@ void virtalloc_unset_release_mechanism(vap_t allocator) {
 
 void virtalloc_set_request_mechanism(vap_t allocator, void *(*request_new_memory)(size_t min_size)) {
     Allocator *alloc = allocator;
+    if (request_new_memory != os_request_memory && request_new_memory != os_request_huge_page_memory)
+        // memory from foreign request mechanisms may not be decommitted (it could be a shared file mapping, ...)
+        alloc->can_decommit = 0;
     alloc->request_new_memory = request_new_memory;
 }
 
@@ -285,14 +562,179 @@ void virtalloc_unset_request_mechanism(vap_t allocator) {
     alloc->request_new_memory = NULL;
 }
 
+/// Returns the memory of free heap slots to the OS (regions that have become entirely free are released, the pages of
+/// other free slots are decommitted) until at most `keep_bytes` of free memory stay resident. Cached early release
+/// blocks are always released. Only allocators created with an OS backend flag can decommit memory. Returns the number
+/// of bytes returned to the OS.
+size_t virtalloc_trim(vap_t allocator, const size_t keep_bytes) {
+    Allocator *alloc = allocator;
+    return virtalloc_trim_impl(alloc, keep_bytes, 1);
+}
+
+/// Starts a background thread that every `interval_ms` milliseconds decommits free heap memory beyond
+/// `keep_resident_bytes` and requests new memory ahead of time whenever less than `reserve_bytes` of free memory are
+/// left, so that mallocs rarely have to wait for the OS. Returns 1 if the scavenger was started, 0 otherwise (e.g. if
+/// the allocator was created with VIRTALLOC_FLAG_VA_ASSUME_THREAD_SAFE_USAGE or already has a scavenger).
+int virtalloc_start_scavenger(vap_t allocator, const unsigned interval_ms, const size_t keep_resident_bytes,
+                              const size_t reserve_bytes) {
+    Allocator *alloc = allocator;
+    return start_scavenger(alloc, interval_ms, keep_resident_bytes, reserve_bytes);
+}
+
+void virtalloc_stop_scavenger(vap_t allocator) {
+    Allocator *alloc = allocator;
+    stop_scavenger(alloc);
+}
+
+/// Returns the size at or above which allocations bypass the heap and are requested from the backing allocator
+/// directly. It only changes over time if VIRTALLOC_FLAG_VA_DYNAMIC_EARLY_RELEASE is set.
+size_t virtalloc_get_early_release_threshold(vap_t allocator) {
+    const Allocator *alloc = allocator;
+    return __atomic_load_n(&alloc->gpa.min_size_for_early_release, __ATOMIC_RELAXED);
+}
+
+/// Moves the early release threshold into [min_size, max_size] and lets free raise it up to max_size (like with
+/// VIRTALLOC_FLAG_VA_DYNAMIC_EARLY_RELEASE). Passing min_size == max_size fixes the threshold.
+void virtalloc_set_early_release_threshold_bounds(vap_t allocator, const size_t min_size, const size_t max_size) {
+    Allocator *alloc = allocator;
+    assert_external(min_size <= max_size && "illegal argument: min_size must not be greater than max_size");
+    const size_t threshold = __atomic_load_n(&alloc->gpa.min_size_for_early_release, __ATOMIC_RELAXED);
+    __atomic_store_n(&alloc->gpa.max_dynamic_early_release_size, max_size, __ATOMIC_RELAXED);
+    __atomic_store_n(&alloc->gpa.min_size_for_early_release, max(min_size, min(threshold, max_size)),
+                     __ATOMIC_RELAXED);
+}
+
+/// Writes the number of live early release blocks (allocations too big for the heap that are requested from the backing
+/// allocator directly) and their total size to the given pointers (either may be NULL).
+void virtalloc_get_early_release_stats(vap_t allocator, size_t *num_blocks, size_t *num_bytes) {
+    Allocator *alloc = allocator;
+    alloc->pre_alloc_op(alloc, ALLOCATOR_PART_BACKING);
+    if (num_blocks)
+        *num_blocks = alloc->num_early_release_blocks;
+    if (num_bytes)
+        *num_bytes = alloc->early_release_bytes;
+    alloc->post_alloc_op(alloc, ALLOCATOR_PART_BACKING);
+}
+
+/// Writes how many reallocs grew a heap slot in place into the free memory after it, how many grew it by merging it with
+/// the free memory before it (moving the data left) and how many had to relocate the data to the given pointers (any
+/// may be NULL).
+void virtalloc_get_realloc_stats(vap_t allocator, size_t *num_grown_forwards, size_t *num_grown_backwards,
+                                 size_t *num_relocated) {
+    const Allocator *alloc = allocator;
+    if (num_grown_forwards)
+        *num_grown_forwards = __atomic_load_n(&alloc->num_reallocs_grown_forwards, __ATOMIC_RELAXED);
+    if (num_grown_backwards)
+        *num_grown_backwards = __atomic_load_n(&alloc->num_reallocs_grown_backwards, __ATOMIC_RELAXED);
+    if (num_relocated)
+        *num_relocated = __atomic_load_n(&alloc->num_reallocs_relocated, __ATOMIC_RELAXED);
+}
+
+/// Creates an arena, a bump allocator for data that is freed all at once. Its memory is requested from the allocator in
+/// chunks of chunk_size bytes (bigger allocations get a chunk of their own). Arenas are not thread safe. Returns NULL if
+/// the arena could not be allocated.
+vaarena_t virtalloc_arena_create(vap_t allocator, const size_t chunk_size) {
+    Allocator *alloc = allocator;
+    return arena_create(alloc, chunk_size);
+}
+
+/// Allocates size bytes from the arena. Arena allocations cannot be freed individually, only by resetting the arena.
+/// Returns NULL if out of memory.
+void *virtalloc_arena_alloc(vaarena_t arena, const size_t size) {
+    return arena_alloc(arena, size);
+}
+
+/// Resizes the arena allocation p of old_size bytes. The most recent allocation is resized in place if its chunk has
+/// room. Others are shrunk in place and copied to a new allocation to grow. Returns NULL (leaving p untouched) if out of memory.
+void *virtalloc_arena_realloc(vaarena_t arena, void *p, const size_t old_size, const size_t new_size) {
+    return arena_realloc(arena, p, old_size, new_size);
+}
+
+/// Returns a mark that virtalloc_arena_reset_to_mark can roll the arena back to.
+void *virtalloc_arena_mark(vaarena_t arena) {
+    const Arena *a = arena;
+    return a->cursor;
+}
+
+/// Frees all allocations made since mark was taken, returning whole chunks to the allocator. Marks taken after mark
+/// become invalid. A NULL mark frees everything.
+void virtalloc_arena_reset_to_mark(vaarena_t arena, void *mark) {
+    arena_reset_to_mark(arena, mark);
+}
+
+/// Frees all allocations of the arena and the arena itself.
+void virtalloc_arena_destroy(vaarena_t arena) {
+    arena_destroy(arena);
+}
+
+/// Creates a pool of objects of object_size bytes aligned to align (0 means 16). The objects are packed densely into
+/// slabs requested from the allocator, and a slab is returned to the allocator once all of its objects are freed. Pools
+/// are not thread safe. Returns NULL if the alignment is not a power of 2, the object is too big for a slab or the pool
+/// could not be allocated.
+vapool_t virtalloc_pool_create(vap_t allocator, const size_t object_size, const size_t align) {
+    Allocator *alloc = allocator;
+    return pool_create(alloc, object_size, align);
+}
+
+/// Allocates an object from the pool in O(1). Returns NULL if out of memory.
+void *virtalloc_pool_alloc(vapool_t pool) {
+    return pool_alloc(pool);
+}
+
+/// Frees an object allocated from the pool in O(1). p may be NULL.
+void virtalloc_pool_free(vapool_t pool, void *p) {
+    pool_free(pool, p);
+}
+
+/// Frees all objects of the pool and the pool itself.
+void virtalloc_pool_destroy(vapool_t pool) {
+    pool_destroy(pool);
+}
+
+/// Sets how many bytes of freed early release blocks may be kept for reuse (0 disables the cache and releases all cached
+/// blocks). VIRTALLOC_FLAG_VA_EARLY_RELEASE_CACHE enables the cache with a default limit.
+void virtalloc_set_early_release_cache_limit(vap_t allocator, const size_t max_bytes) {
+    Allocator *alloc = allocator;
+    alloc->pre_alloc_op(alloc, ALLOCATOR_PART_BACKING);
+    early_release_cache_set_limit(alloc, max_bytes);
+    alloc->post_alloc_op(alloc, ALLOCATOR_PART_BACKING);
+}
+
+/// Also disables adaptive exploration for the GPA because the budget is now fixed by the user.
 void virtalloc_set_max_gpa_slot_checks_before_oom(vap_t allocator, const size_t max_slot_checks) {
     Allocator *alloc = allocator;
+    alloc->pre_alloc_op(alloc, ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA);
+    alloc->gpa.tuner.is_enabled = 0;
     alloc->gpa.max_slot_checks_before_oom = max_slot_checks;
+    alloc->post_alloc_op(alloc, ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA);
 }
 
+/// Also disables adaptive exploration for the SMA because the budget is now fixed by the user.
 void virtalloc_set_max_sma_slot_checks_before_oom(vap_t allocator, const size_t max_slot_checks) {
     Allocator *alloc = allocator;
+    alloc->pre_alloc_op(alloc, ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA);
+    alloc->sma.tuner.is_enabled = 0;
     alloc->sma.max_slot_checks_before_oom = max_slot_checks;
+    alloc->post_alloc_op(alloc, ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA);
+}
+
+/// Lets the allocator tune its slot check budgets itself so that the average number of probed slots per allocation
+/// stays under `target_probes`. Resets the budgets set through virtalloc_set_max_*_slot_checks_before_oom.
+void virtalloc_enable_adaptive_exploration(vap_t allocator, const size_t target_probes) {
+    Allocator *alloc = allocator;
+    alloc->pre_alloc_op(alloc, ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA);
+    exploration_tuner_enable(&alloc->gpa.tuner, &alloc->gpa.max_slot_checks_before_oom, target_probes);
+    exploration_tuner_enable(&alloc->sma.tuner, &alloc->sma.max_slot_checks_before_oom, target_probes);
+    alloc->post_alloc_op(alloc, ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA);
+}
+
+/// Freezes the slot check budgets at their current (tuned) values.
+void virtalloc_disable_adaptive_exploration(vap_t allocator) {
+    Allocator *alloc = allocator;
+    alloc->pre_alloc_op(alloc, ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA);
+    alloc->gpa.tuner.is_enabled = 0;
+    alloc->sma.tuner.is_enabled = 0;
+    alloc->post_alloc_op(alloc, ALLOCATOR_PART_SMA | ALLOCATOR_PART_GPA);
 }
 
 void virtalloc_dump_allocator_to_file(FILE *file, vap_t allocator) {
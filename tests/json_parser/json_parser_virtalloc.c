@@ -11,6 +11,8 @@
  * Integers are stored as long long (JSON_INTEGER) and floats as double (JSON_FLOAT).
  *
  * This port replaces all libc memory calls with calls to your custom allocator.
+ * If JSON_PARSER_USE_ARENA is defined, everything is allocated from an arena instead,
+ * which is reset at once rather than freeing the parse tree object by object.
  *
  * Compile with:
  *     gcc -std=c99 -Wall -Wextra -DTEST_JSON_PARSER -o json_parser_virtalloc json_parser_virtalloc.c
@@ -22,6 +24,7 @@
 #include <string.h>
 #include <errno.h>
 #include <stdarg.h>
+#include <time.h>
 #include "virtalloc.h"
 
 #ifndef ERANGE
@@ -34,29 +37,63 @@
 */
 static vap_t alloc = NULL;
 
+#ifdef JSON_PARSER_USE_ARENA
+/* the arena all allocations are made from (created in main()) */
+static vaarena_t arena = NULL;
+#endif
+
 static void *virtalloc_malloc_wrapper(vap_t allocator, size_t size) {
     static int call_count = 0;
     call_count++;
+#ifdef JSON_PARSER_USE_ARENA
+    (void) allocator;
+    void *out = virtalloc_arena_alloc(arena, size);
+#else
     void *out = virtalloc_malloc(allocator, size);
+#endif
     if (!out)
         fprintf(stderr, "f in malloc (call nr. %d)\n", call_count);
     return out;
 }
 
-static void *virtalloc_realloc_wrapper(vap_t allocator, void *p, size_t size) {
+static void *virtalloc_realloc_wrapper(vap_t allocator, void *p, size_t old_size, size_t size) {
     static int call_count = 0;
     call_count++;
     if (call_count == 12565) {
         int a = 0;
     }
+#ifdef JSON_PARSER_USE_ARENA
+    (void) allocator;
+    void *out = virtalloc_arena_realloc(arena, p, old_size, size);
+#else
+    (void) old_size;
     void *out = virtalloc_realloc(allocator, p, size);
+#endif
     if (!out)
         fprintf(stderr, "f in realloc (call nr. %d)\n", call_count);
     return out;
 }
 
 static void virtalloc_free_wrapper(vap_t allocator, void *p) {
+#ifdef JSON_PARSER_USE_ARENA
+    /* arena allocations are freed all at once */
+    (void) allocator;
+    (void) p;
+#else
     virtalloc_free(allocator, p);
+#endif
+}
+
+/* Returns how many bytes of p (which was allocated with size bytes) may be used. */
+static size_t virtalloc_usable_size_wrapper(vap_t allocator, void *p, size_t size) {
+#ifdef JSON_PARSER_USE_ARENA
+    (void) allocator;
+    (void) p;
+    return size;
+#else
+    (void) size;
+    return virtalloc_usable_size(allocator, p);
+#endif
 }
 
 /* --- Data Structures --- */
@@ -135,12 +172,13 @@ static void skip_whitespace(const char **p) {
 static int append_char(char **buffer, size_t *len, size_t *cap, char c) {
     if (*len + 1 >= *cap) {
         size_t new_cap = (*cap) * 2;
-        char *new_buf = virtalloc_realloc_wrapper(alloc, *buffer, new_cap);
+        char *new_buf = virtalloc_realloc_wrapper(alloc, *buffer, *cap, new_cap);
         if (!new_buf) {
             return 0;
         }
         *buffer = new_buf;
-        *cap = new_cap;
+        /* use the slack the allocator rounded up to, which saves reallocs */
+        *cap = virtalloc_usable_size_wrapper(alloc, new_buf, new_cap);
     }
     (*buffer)[(*len)++] = c;
     return 1;
@@ -191,6 +229,7 @@ static JSONValue *parse_string(const char **p) {
     size_t len = 0;
     char *buffer = virtalloc_malloc_wrapper(alloc, capacity);
     if (!buffer) return NULL;
+    capacity = virtalloc_usable_size_wrapper(alloc, buffer, capacity);
 
     while (**p) {
         char c = *(*p)++;
@@ -389,6 +428,7 @@ static JSONValue *parse_array(const char **p) {
         if (value->u.array.count >= value->u.array.capacity) {
             size_t new_capacity = value->u.array.capacity * 2;
             JSONValue **new_items = virtalloc_realloc_wrapper(alloc, value->u.array.items,
+                                                              value->u.array.capacity * sizeof(JSONValue *),
                                                               new_capacity * sizeof(JSONValue *));
             if (!new_items) {
                 free_json_value(elem);
@@ -396,7 +436,9 @@ static JSONValue *parse_array(const char **p) {
                 return NULL;
             }
             value->u.array.items = new_items;
-            value->u.array.capacity = new_capacity;
+            value->u.array.capacity = virtalloc_usable_size_wrapper(alloc, new_items,
+                                                                    new_capacity * sizeof(JSONValue *))
+                                      / sizeof(JSONValue *);
         }
         value->u.array.items[value->u.array.count++] = elem;
         skip_whitespace(p);
@@ -475,8 +517,11 @@ static JSONValue *parse_object(const char **p) {
         /* Resize if necessary */
         if (value->u.object.count >= value->u.object.capacity) {
             size_t new_capacity = value->u.object.capacity * 2;
-            char **new_keys = virtalloc_realloc_wrapper(alloc, value->u.object.keys, new_capacity * sizeof(char *));
+            char **new_keys = virtalloc_realloc_wrapper(alloc, value->u.object.keys,
+                                                        value->u.object.capacity * sizeof(char *),
+                                                        new_capacity * sizeof(char *));
             JSONValue **new_values = virtalloc_realloc_wrapper(alloc, value->u.object.values,
+                                                               value->u.object.capacity * sizeof(JSONValue *),
                                                                new_capacity * sizeof(JSONValue *));
             if (!new_keys || !new_values) {
                 virtalloc_free_wrapper(alloc, key);
@@ -488,7 +533,12 @@ static JSONValue *parse_object(const char **p) {
             }
             value->u.object.keys = new_keys;
             value->u.object.values = new_values;
-            value->u.object.capacity = new_capacity;
+            size_t keys_capacity = virtalloc_usable_size_wrapper(alloc, new_keys, new_capacity * sizeof(char *))
+                                   / sizeof(char *);
+            size_t values_capacity = virtalloc_usable_size_wrapper(alloc, new_values,
+                                                                   new_capacity * sizeof(JSONValue *))
+                                     / sizeof(JSONValue *);
+            value->u.object.capacity = keys_capacity < values_capacity ? keys_capacity : values_capacity;
         }
         value->u.object.keys[value->u.object.count] = key;
         value->u.object.values[value->u.object.count] = val;
@@ -731,6 +781,12 @@ static char *read_file(const char *filename) {
     return buffer;
 }
 
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
 int main(void) {
     /* Initialize the allocator (for example, with 512MB and default settings) */
     const int flags = VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS;
@@ -743,6 +799,14 @@ int main(void) {
         fprintf(stderr, "Failed to initialize custom allocator.\n");
         return 1;
     }
+#ifdef JSON_PARSER_USE_ARENA
+    arena = virtalloc_arena_create(alloc, 0);
+    if (!arena) {
+        fprintf(stderr, "Failed to create arena.\n");
+        virtalloc_destroy_allocator(alloc);
+        return 1;
+    }
+#endif
 
     /* Read the JSON file */
     char *orig_json = read_file("test_giant.json");
@@ -752,8 +816,15 @@ int main(void) {
         return 1;
     }
 
+#ifdef JSON_PARSER_USE_ARENA
+    /* everything allocated after this point belongs to the parse and is released by resetting to it */
+    void *parse_mark = virtalloc_arena_mark(arena);
+#endif
+
     /* Parse the JSON */
+    const double parse_start = now_seconds();
     JSONValue *root = json_parse(orig_json);
+    const double parse_time = now_seconds() - parse_start;
     if (!root) {
         fprintf(stderr, "Failed to parse JSON.\n");
         virtalloc_free_wrapper(alloc, orig_json);
@@ -798,10 +869,20 @@ int main(void) {
     }
 
     /* Cleanup */
-    free_json_value(root);
     virtalloc_free_wrapper(alloc, ser_json);
+    const double teardown_start = now_seconds();
+#ifdef JSON_PARSER_USE_ARENA
+    virtalloc_arena_reset_to_mark(arena, parse_mark);
+#else
+    free_json_value(root);
+#endif
+    const double teardown_time = now_seconds() - teardown_start;
     virtalloc_free_wrapper(alloc, orig_json);
+    printf("parse: %.3f ms, teardown: %.3f ms\n", parse_time * 1e3, teardown_time * 1e3);
 
+#ifdef JSON_PARSER_USE_ARENA
+    virtalloc_arena_destroy(arena);
+#endif
     virtalloc_destroy_allocator(alloc);
     return 0;
 }
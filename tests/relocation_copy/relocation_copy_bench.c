@@ -0,0 +1,97 @@
+/*
+ * relocation_copy_bench.c
+ *
+ * Compares the non-temporal copy used by relocating reallocs to libc memmove for block sizes from 64 KiB to 256 MiB.
+ * Besides the copy itself, it measures how long it takes to read a small working set afterwards, which is what suffers
+ * when a copy evicts it from the cache.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "virtalloc/relocation_copy.h"
+
+#define MIN_BLOCK_SIZE ((size_t) 64 * 1024)
+#define MAX_BLOCK_SIZE ((size_t) 256 * 1024 * 1024)
+#define BYTES_PER_MEASUREMENT ((size_t) 2 * 1024 * 1024 * 1024)
+#define WORKING_SET_SIZE ((size_t) 512 * 1024)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static volatile size_t sink;
+
+static void touch_working_set(const size_t *working_set) {
+    size_t sum = 0;
+    for (size_t i = 0; i < WORKING_SET_SIZE / sizeof(size_t); i += 8)
+        sum += working_set[i];
+    sink = sum;
+}
+
+static void benchmark(const char *name, void (*copy)(void *, const void *, size_t), unsigned char *dst,
+                      const unsigned char *src, const size_t size, const size_t *working_set) {
+    const size_t reps = BYTES_PER_MEASUREMENT / size ? BYTES_PER_MEASUREMENT / size : 1;
+    double copy_time = 0, touch_time = 0;
+    for (size_t r = 0; r < reps; r++) {
+        touch_working_set(working_set);
+        const double start = now_seconds();
+        copy(dst, src, size);
+        const double copied = now_seconds();
+        touch_working_set(working_set);
+        touch_time += now_seconds() - copied;
+        copy_time += copied - start;
+    }
+    printf("%-18s %10zu KiB  %8.2f GiB/s  working set reread %8.1f ns\n", name, size / 1024,
+           (double) size * (double) reps / copy_time / (1024.0 * 1024.0 * 1024.0), touch_time / (double) reps * 1e9);
+}
+
+/// copies size bytes (and size - 1 bytes to an unaligned dst) with copy into a cleared dst and checks the result. src
+/// gets a pattern that differs per size, so a copy that writes nothing or the wrong bytes can't match by accident.
+static int check_copy(const char *name, void (*copy)(void *, const void *, size_t), unsigned char *dst,
+                      unsigned char *src, const size_t size) {
+    for (size_t i = 0; i < size; i++)
+        src[i] = (unsigned char) (i * 31 + size / 1024);
+    for (size_t offset = 0; offset < 2; offset++) {
+        memset(dst, 0, size);
+        copy(dst + offset, src, size - offset);
+        if (memcmp(dst + offset, src, size - offset) != 0 || (offset && dst[0] != 0)) {
+            fprintf(stderr, "%s produced a wrong copy of %zu bytes\n", name, size - offset);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void libc_memmove(void *dst, const void *src, const size_t size) {
+    memmove(dst, src, size);
+}
+
+int main(void) {
+    unsigned char *src = malloc(MAX_BLOCK_SIZE);
+    unsigned char *dst = malloc(MAX_BLOCK_SIZE);
+    size_t *working_set = malloc(WORKING_SET_SIZE);
+    if (!src || !dst || !working_set) {
+        fprintf(stderr, "failed to allocate the benchmark buffers\n");
+        return 1;
+    }
+    memset(src, 0x5a, MAX_BLOCK_SIZE);
+    memset(dst, 0, MAX_BLOCK_SIZE);
+    memset(working_set, 1, WORKING_SET_SIZE);
+
+    for (size_t size = MIN_BLOCK_SIZE; size <= MAX_BLOCK_SIZE; size *= 4) {
+        if (!check_copy("memmove", libc_memmove, dst, src, size)
+            || !check_copy("non_temporal_copy", non_temporal_copy, dst, src, size))
+            return 1;
+        benchmark("memmove", libc_memmove, dst, src, size, working_set);
+        benchmark("non_temporal_copy", non_temporal_copy, dst, src, size, working_set);
+    }
+
+    free(src);
+    free(dst);
+    free(working_set);
+    return 0;
+}
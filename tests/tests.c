@@ -1,7 +1,14 @@
 #include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
 #include "testing.h"
 #include "virtalloc.h"
 #include "virtalloc/gp_memory_slot_meta.h"
+#include "virtalloc/allocator.h"
+#include "virtalloc/math_utils.h"
+#include "virtalloc/relocation_copy.h"
+#include "virtalloc/pool.h"
 #define LARGE_ALLOC_REQUIRED_ALIGN 64
 #include "test_utils.h"
 
@@ -394,7 +401,7 @@ int monolithic_test_rr_8() {
 
     int *y_realloc_2 = virtalloc_realloc(alloc, y_realloc, 96 * sizeof(int));
     TEST_ASSERT_MSG(y_realloc != y_realloc_2, "realloc without free space didn't move");
-    ASSERT_CORRECT_CONTENT(y_realloc, 15);
+    ASSERT_CORRECT_CONTENT(y_realloc_2, 15);
 
     virtalloc_destroy_allocator(alloc);
     return 0;
@@ -636,6 +643,1333 @@ fail:
     return 1;
 }
 
+int test_page_map_classification_13() {
+    vap_t alloc = virtalloc_new_allocator(1024 * sizeof(double),
+                                          SMALL_HEAP_FLAGS | VIRTALLOC_FLAG_VA_PAGE_MAP_CLASSIFICATION);
+    virtalloc_set_release_mechanism(alloc, release_memory);
+    virtalloc_set_request_mechanism(alloc, request_new_memory);
+
+    // one allocation of each kind: small (RR slot), medium (GP slot) and large (early release slot)
+    MAKE_AUTO_INIT_INT_ALLOC(small, 4);
+    MAKE_AUTO_INIT_INT_ALLOC(medium, 128);
+    MAKE_AUTO_INIT_INT_ALLOC(large, 4096);
+
+    // realloc has to classify the pointers correctly to keep the contents intact
+    int *small_realloc = virtalloc_realloc(alloc, small, 32 * sizeof(int));
+    TEST_ASSERT_MSG(small_realloc, "small realloc failed");
+    ASSERT_CORRECT_CONTENT(small_realloc, 4);
+    int *medium_realloc = virtalloc_realloc(alloc, medium, 256 * sizeof(int));
+    TEST_ASSERT_MSG(medium_realloc, "medium realloc failed");
+    ASSERT_CORRECT_CONTENT(medium_realloc, 128);
+    int *large_realloc = virtalloc_realloc(alloc, large, 8192 * sizeof(int));
+    TEST_ASSERT_MSG(large_realloc, "large realloc failed");
+    ASSERT_CORRECT_CONTENT(large_realloc, 4096);
+
+    virtalloc_free(alloc, small_realloc);
+    virtalloc_free(alloc, medium_realloc);
+    virtalloc_free(alloc, large_realloc);
+
+    // freed memory must be reusable
+    MAKE_AUTO_INIT_INT_ALLOC(reused, 128);
+    ASSERT_CORRECT_CONTENT(reused, 128);
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_adaptive_exploration_14() {
+    vap_t alloc = virtalloc_new_allocator(1024 * sizeof(double),
+                                          SMALL_HEAP_FLAGS | VIRTALLOC_FLAG_VA_ADAPTIVE_EXPLORATION);
+    virtalloc_set_release_mechanism(alloc, release_memory);
+    virtalloc_set_request_mechanism(alloc, request_new_memory);
+    const Allocator *va = alloc;
+
+    // fill the SMA and GPA, then punch holes into both so that searches have to skip allocated/too small slots
+    int *small[256], *medium[64], *p, n;
+    for (int k = 0; k < 256; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(p, 4);
+        small[k] = p;
+    }
+    for (int k = 0; k < 64; k++) {
+        n = 16 + k % 4 * 16;
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(p, n);
+        medium[k] = p;
+    }
+    for (int k = 0; k < 256; k += 2)
+        virtalloc_free(alloc, small[k]);
+    for (int k = 0; k < 64; k += 2)
+        virtalloc_free(alloc, medium[k]);
+    for (int k = 0; k < 256; k += 2) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(p, 4);
+        small[k] = p;
+    }
+    for (int k = 0; k < 64; k += 2) {
+        n = 16 + k % 4 * 16;
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(p, n);
+        medium[k] = p;
+    }
+
+    TEST_ASSERT_MSG(va->sma.tuner.is_enabled && va->gpa.tuner.is_enabled, "tuner should be enabled");
+    TEST_ASSERT_MSG(va->sma.max_slot_checks_before_oom >= va->sma.tuner.min_budget
+                    && va->sma.max_slot_checks_before_oom <= va->sma.tuner.max_budget, "SMA budget out of bounds");
+    TEST_ASSERT_MSG(va->gpa.max_slot_checks_before_oom >= va->gpa.tuner.min_budget
+                    && va->gpa.max_slot_checks_before_oom <= va->gpa.tuner.max_budget, "GPA budget out of bounds");
+    for (int k = 0; k < 256; k++) {
+        p = small[k];
+        ASSERT_CORRECT_CONTENT(p, 4);
+    }
+    for (int k = 0; k < 64; k++) {
+        p = medium[k];
+        n = 16 + k % 4 * 16;
+        ASSERT_CORRECT_CONTENT(p, n);
+    }
+
+    // a user-provided budget overrides the tuner
+    virtalloc_set_max_sma_slot_checks_before_oom(alloc, 16);
+    TEST_ASSERT_MSG(!va->sma.tuner.is_enabled && va->sma.max_slot_checks_before_oom == 16,
+                    "setting the budget should disable the tuner");
+    virtalloc_destroy_allocator(alloc);
+
+    // cheap searches that keep failing make the tuner explore more before growing
+    alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS
+                                                 | VIRTALLOC_FLAG_VA_ADAPTIVE_EXPLORATION);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    va = alloc;
+    const size_t gpa_budget_before = va->gpa.max_slot_checks_before_oom;
+    for (int k = 0; k < 64; k++)
+        TEST_ASSERT_MSG(!virtalloc_malloc(alloc, 2 * 1024 * 1024), "allocation bigger than the heap succeeded");
+    TEST_ASSERT_MSG(va->gpa.max_slot_checks_before_oom > gpa_budget_before,
+                    "failing searches should raise the GPA budget");
+
+    // long searches make the tuner give up sooner: fill the SMA of the heap, which cannot grow, then free every 32nd
+    // slot so that every allocation has to skip 31 allocated slots
+    static void *slots[1024 * 1024 / 32];
+    size_t num_slots = 0;
+    while (num_slots < sizeof(slots) / sizeof(slots[0]) && (slots[num_slots] = virtalloc_malloc(alloc, 8)))
+        num_slots++;
+    TEST_ASSERT_MSG(num_slots > 1024 && num_slots < sizeof(slots) / sizeof(slots[0]), "heap should fill up");
+    for (size_t k = 0; k < num_slots; k += 32)
+        virtalloc_free(alloc, slots[k]);
+    const size_t sma_budget_before = va->sma.max_slot_checks_before_oom;
+    for (size_t k = 0; k < num_slots; k += 32)
+        virtalloc_malloc(alloc, 8);
+    TEST_ASSERT_MSG(va->sma.max_slot_checks_before_oom < sma_budget_before,
+                    "long searches should lower the SMA budget");
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+typedef struct PerThreadSmaWorkerArgs {
+    vap_t alloc;
+    int *kept[256];
+    int failed;
+} PerThreadSmaWorkerArgs;
+
+static void *per_thread_sma_worker(void *p) {
+    PerThreadSmaWorkerArgs *args = p;
+    vap_t alloc = args->alloc;
+    int *slots[512];
+    for (int round = 0; round < 8; round++) {
+        for (int k = 0; k < 512; k++) {
+            int *q;
+            MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 4);
+            slots[k] = q;
+        }
+        for (int k = 0; k < 512; k++) {
+            int *q = slots[k];
+            ASSERT_CORRECT_CONTENT(q, 4);
+            virtalloc_free(alloc, q);
+        }
+    }
+    // keep some slots alive so that the main thread frees them (foreign frees) and the ring is worth adopting
+    for (int k = 0; k < 256; k++) {
+        int *q;
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 4);
+        args->kept[k] = q;
+    }
+    return NULL;
+fail:
+    args->failed = 1;
+    return NULL;
+}
+
+int test_per_thread_sma_15() {
+    vap_t alloc = virtalloc_new_allocator(1024 * sizeof(double), SMALL_HEAP_FLAGS | VIRTALLOC_FLAG_VA_PER_THREAD_SMA);
+    virtalloc_set_release_mechanism(alloc, release_memory);
+    virtalloc_set_request_mechanism(alloc, request_new_memory);
+
+    PerThreadSmaWorkerArgs args[4] = {0};
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++) {
+        args[t].alloc = alloc;
+        TEST_ASSERT_MSG(!pthread_create(&threads[t], NULL, per_thread_sma_worker, &args[t]), "failed to spawn thread");
+    }
+    for (int t = 0; t < 4; t++)
+        pthread_join(threads[t], NULL);
+
+    // the workers have exited, so their rings are abandoned now: free their slots from this thread
+    for (int t = 0; t < 4; t++) {
+        TEST_ASSERT_MSG(!args[t].failed, "worker thread saw corrupted memory");
+        for (int k = 0; k < 256; k++) {
+            int *q = args[t].kept[k];
+            ASSERT_CORRECT_CONTENT(q, 4);
+            virtalloc_free(alloc, q);
+        }
+    }
+
+    // small allocations on this thread must keep working (and may adopt the abandoned rings)
+    int *small[4096], *q;
+    for (int k = 0; k < 4096; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 4);
+        small[k] = q;
+    }
+    for (int k = 0; k < 4096; k++) {
+        q = small[k];
+        ASSERT_CORRECT_CONTENT(q, 4);
+    }
+    for (int k = 0; k < 4096; k++)
+        virtalloc_free(alloc, small[k]);
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+typedef struct SplitLocksWorkerArgs {
+    vap_t alloc;
+    int failed;
+} SplitLocksWorkerArgs;
+
+static void *split_locks_worker(void *p) {
+    SplitLocksWorkerArgs *args = p;
+    vap_t alloc = args->alloc;
+    // small slots go to the SMA, medium ones to the GPA and huge ones take the early release path
+    static const int sizes[] = {4, 64, 200, 2048};
+    int *slots[64];
+    for (int round = 0; round < 32; round++) {
+        for (int k = 0; k < 64; k++) {
+            int *q;
+            const int n = sizes[(k + round) % 4];
+            MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+            slots[k] = q;
+        }
+        // grow every other allocation across the SMA/GPA and GPA/early release boundaries
+        for (int k = 0; k < 64; k += 2) {
+            int *q = slots[k];
+            const int n = sizes[(k + round) % 4];
+            ASSERT_CORRECT_CONTENT(q, n);
+            q = virtalloc_realloc(alloc, q, 4 * n * sizeof(int));
+            if (!q)
+                goto fail;
+            ASSERT_CORRECT_CONTENT(q, n);
+            slots[k] = q;
+        }
+        for (int k = 0; k < 64; k++) {
+            int *q = slots[k];
+            const int n = sizes[(k + round) % 4];
+            ASSERT_CORRECT_CONTENT(q, n);
+            virtalloc_free(alloc, q);
+        }
+    }
+    return NULL;
+fail:
+    args->failed = 1;
+    return NULL;
+}
+
+int test_split_locks_16() {
+    vap_t alloc = virtalloc_new_allocator(1024 * sizeof(double), SMALL_HEAP_FLAGS);
+    virtalloc_set_release_mechanism(alloc, release_memory);
+    virtalloc_set_request_mechanism(alloc, request_new_memory);
+
+    SplitLocksWorkerArgs args[4] = {0};
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++) {
+        args[t].alloc = alloc;
+        TEST_ASSERT_MSG(!pthread_create(&threads[t], NULL, split_locks_worker, &args[t]), "failed to spawn thread");
+    }
+    for (int t = 0; t < 4; t++)
+        pthread_join(threads[t], NULL);
+    for (int t = 0; t < 4; t++)
+        TEST_ASSERT_MSG(!args[t].failed, "worker thread saw corrupted memory");
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+typedef struct LockHolderArgs {
+    Allocator *va;
+    pthread_barrier_t *barrier;
+} LockHolderArgs;
+
+static void *gpa_lock_holder(void *p) {
+    const LockHolderArgs *args = p;
+    args->va->pre_alloc_op(args->va, ALLOCATOR_PART_GPA);
+    pthread_barrier_wait(args->barrier);
+    // the main thread runs its try operations now
+    pthread_barrier_wait(args->barrier);
+    // releasing the lock drains the deferred frees
+    args->va->post_alloc_op(args->va, ALLOCATOR_PART_GPA);
+    return NULL;
+}
+
+int test_try_malloc_and_free_17() {
+    vap_t alloc = virtalloc_new_allocator(1024 * sizeof(double), SMALL_HEAP_FLAGS);
+    Allocator *va = alloc;
+    virtalloc_set_release_mechanism(alloc, release_memory);
+    virtalloc_set_request_mechanism(alloc, request_new_memory);
+
+    int *medium, *small, *q;
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(medium, 64);
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(small, 4);
+    const GPMemorySlotMeta *medium_meta = (void *) medium - sizeof(GPMemorySlotMeta);
+
+    // uncontended try operations behave like the normal ones
+    TEST_ASSERT_MSG(virtalloc_try_malloc(alloc, 64 * sizeof(int), (void **) &q) == VIRTALLOC_TRY_OK && q,
+                    "uncontended try_malloc should succeed");
+    TEST_ASSERT_MSG(virtalloc_try_free(alloc, q) == VIRTALLOC_TRY_OK, "uncontended try_free should succeed");
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, 2);
+    LockHolderArgs args = {.va = va, .barrier = &barrier};
+    pthread_t holder;
+    TEST_ASSERT_MSG(!pthread_create(&holder, NULL, gpa_lock_holder, &args), "failed to spawn thread");
+    pthread_barrier_wait(&barrier);
+
+    const int malloc_status = virtalloc_try_malloc(alloc, 64 * sizeof(int), (void **) &q);
+    const int medium_free_status = virtalloc_try_free(alloc, medium);
+    const int small_free_status = virtalloc_try_free(alloc, small);
+    const int medium_is_free_before_drain = medium_meta->is_free;
+
+    pthread_barrier_wait(&barrier);
+    pthread_join(holder, NULL);
+    pthread_barrier_destroy(&barrier);
+
+    TEST_ASSERT_MSG(malloc_status == VIRTALLOC_TRY_WOULD_BLOCK && !q, "try_malloc must not wait for the GPA lock");
+    TEST_ASSERT_MSG(medium_free_status == VIRTALLOC_TRY_DEFERRED && !medium_is_free_before_drain,
+                    "try_free of a GPA slot should be deferred while the GPA lock is held");
+    TEST_ASSERT_MSG(small_free_status == VIRTALLOC_TRY_OK, "small slots are freed without a lock");
+    TEST_ASSERT_MSG(medium_meta->is_free && !va->deferred_gpa_frees,
+                    "releasing the GPA lock should drain the deferred frees");
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+static int run_os_backend_workload(const int backend_flag) {
+    // no request/release mechanism is set: the built-in OS backend handles growth and early release blocks
+    vap_t alloc = virtalloc_new_allocator(1024 * sizeof(double), SMALL_HEAP_FLAGS | backend_flag);
+    if (!alloc)
+        return 1;
+    int *slots[256], *q;
+    for (int k = 0; k < 256; k++) {
+        const int n = k % 8 == 7 ? 4096 : 4 + k % 4 * 64;
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+        slots[k] = q;
+    }
+    for (int k = 0; k < 256; k++) {
+        const int n = k % 8 == 7 ? 4096 : 4 + k % 4 * 64;
+        q = slots[k];
+        ASSERT_CORRECT_CONTENT(q, n);
+        if (k % 2)
+            virtalloc_free(alloc, q);
+    }
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_os_backend_18() {
+    TEST_ASSERT_MSG(!run_os_backend_workload(VIRTALLOC_FLAG_VA_OS_BACKEND), "OS backend workload failed");
+    TEST_ASSERT_MSG(!run_os_backend_workload(VIRTALLOC_FLAG_VA_HUGE_PAGES), "huge page backend workload failed");
+    return 0;
+fail:
+    return 1;
+}
+
+int test_reserved_address_space_19() {
+    vap_t alloc = virtalloc_new_allocator(1024 * sizeof(double),
+                                          SMALL_HEAP_FLAGS | VIRTALLOC_FLAG_VA_RESERVE_ADDRESS_SPACE);
+    TEST_ASSERT_MSG(alloc, "failed to reserve address space");
+    const Allocator *va = alloc;
+    int *slots[64], *q;
+    // grow the heap well beyond its initial size (without early release blocks, which are mapped separately): it must
+    // stay inside the reservation and never add owned regions
+    for (int k = 0; k < 64; k++) {
+        const int n = 64 + k * 12;
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+        slots[k] = q;
+        TEST_ASSERT_MSG((void *) q > (void *) va && (void *) q < va->committed_end,
+                        "allocation does not lie in the committed part of the reservation");
+    }
+    TEST_ASSERT_MSG(va->release_only_allocator, "growing a reservation must not add separately released regions");
+    for (int k = 0; k < 64; k++) {
+        const int n = 64 + k * 12;
+        q = slots[k];
+        ASSERT_CORRECT_CONTENT(q, n);
+        virtalloc_free(alloc, q);
+    }
+
+    // after freeing everything, the heap has coalesced back into a single free slot that spans all committed memory
+    const GPMemorySlotMeta *first_meta = va->gpa.first_slot - sizeof(GPMemorySlotMeta);
+    TEST_ASSERT_MSG(first_meta->is_free && first_meta->next == va->gpa.first_slot
+                    && va->gpa.first_slot + first_meta->size == va->committed_end,
+                    "the heap should be one contiguous wilderness slot");
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_trim_20() {
+    // the initial heap is big enough to be decommitted, later regions are requested separately and can be released
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, SMALL_HEAP_FLAGS_NO_RR | VIRTALLOC_FLAG_VA_OS_BACKEND);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+    const Allocator *va = alloc;
+    int *slots[1024], *q;
+    for (int k = 0; k < 1024; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 512);
+        slots[k] = q;
+    }
+    TEST_ASSERT_MSG(!va->release_only_allocator, "the allocator should have requested additional regions");
+    for (int k = 0; k < 1024; k++) {
+        q = slots[k];
+        ASSERT_CORRECT_CONTENT(q, 512);
+        virtalloc_free(alloc, q);
+    }
+
+    TEST_ASSERT_MSG(virtalloc_trim(alloc, 0) > 0, "trimming an entirely free heap should return memory");
+    // only the allocator's own memory is left, as a single decommitted slot
+    const GPMemorySlotMeta *first_meta = va->gpa.first_slot - sizeof(GPMemorySlotMeta);
+    TEST_ASSERT_MSG(first_meta->next == va->gpa.first_slot && !first_meta->memory_is_owned,
+                    "all requested regions should have been released");
+    TEST_ASSERT_MSG(first_meta->is_free && first_meta->is_decommitted, "the remaining slot should be decommitted");
+    TEST_ASSERT_MSG(virtalloc_trim(alloc, 0) == 0, "a trimmed heap has nothing left to return");
+
+    // decommitted memory can be reused like any other memory
+    for (int k = 0; k < 1024; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 512);
+        slots[k] = q;
+    }
+    for (int k = 0; k < 1024; k++) {
+        q = slots[k];
+        ASSERT_CORRECT_CONTENT(q, 512);
+        virtalloc_free(alloc, q);
+    }
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+/// counts the regions the allocator requested after its creation
+static size_t count_owned_regions(const Allocator *va) {
+    size_t num_regions = 0;
+    const void *slot = va->gpa.first_slot;
+    do {
+        const GPMemorySlotMeta *meta = slot - sizeof(GPMemorySlotMeta);
+        num_regions += meta->memory_is_owned;
+        slot = meta->next;
+    } while (slot != va->gpa.first_slot);
+    return num_regions;
+}
+
+int test_scavenger_21() {
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, SMALL_HEAP_FLAGS_NO_RR | VIRTALLOC_FLAG_VA_OS_BACKEND);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+    const Allocator *va = alloc;
+    int *slots[512], *q;
+    for (int k = 0; k < 256; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 512);
+        slots[k] = q;
+    }
+    for (int k = 0; k < 256; k++) {
+        q = slots[k];
+        ASSERT_CORRECT_CONTENT(q, 512);
+        virtalloc_free(alloc, q);
+    }
+
+    // the scavenger runs asynchronously, so give it a few chances to do a pass
+    const size_t reserve_bytes = 4 * 1024 * 1024;
+    const struct timespec pass_time = {.tv_sec = 0, .tv_nsec = 20 * 1000 * 1000};
+    int did_scavenge = 0;
+    for (int k = 0; k < 50 && !did_scavenge; k++) {
+        TEST_ASSERT_MSG(virtalloc_start_scavenger(alloc, 1, 0, reserve_bytes), "failed to start scavenger");
+        TEST_ASSERT_MSG(!virtalloc_start_scavenger(alloc, 1, 0, reserve_bytes),
+                        "an allocator must not have two scavengers");
+        nanosleep(&pass_time, NULL);
+        virtalloc_stop_scavenger(alloc);
+        const GPMemorySlotMeta *first_meta = va->gpa.first_slot - sizeof(GPMemorySlotMeta);
+        did_scavenge = !va->release_only_allocator && first_meta->is_free && first_meta->is_decommitted;
+    }
+    TEST_ASSERT_MSG(did_scavenge, "the scavenger should have refilled the reserve and decommitted the free memory");
+
+    // the reserve is used before the allocator has to request new memory
+    const size_t num_regions = count_owned_regions(va);
+    TEST_ASSERT_MSG(num_regions > 0, "the reserve should be a separate region");
+    for (int k = 0; k < 512; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 768);
+        slots[k] = q;
+    }
+    TEST_ASSERT_MSG(count_owned_regions(va) == num_regions, "allocations should have been served from the reserve");
+    for (int k = 0; k < 512; k++) {
+        q = slots[k];
+        ASSERT_CORRECT_CONTENT(q, 768);
+        virtalloc_free(alloc, q);
+    }
+
+    // destroying the allocator stops a running scavenger
+    TEST_ASSERT_MSG(virtalloc_start_scavenger(alloc, 1, 0, reserve_bytes), "failed to restart scavenger");
+    virtalloc_destroy_allocator(alloc);
+
+    alloc = virtalloc_new_allocator(1024 * 1024, SMALL_HEAP_FLAGS_NO_RR | VIRTALLOC_FLAG_VA_ASSUME_THREAD_SAFE_USAGE);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    TEST_ASSERT_MSG(!virtalloc_start_scavenger(alloc, 1, 0, 0),
+                    "a scavenger must not be started for allocators that are assumed to be used by a single thread");
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_dynamic_early_release_22() {
+    // early release blocks need a request mechanism, which the OS backend provides
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND
+                                                       | VIRTALLOC_FLAG_VA_DYNAMIC_EARLY_RELEASE);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    const size_t initial_threshold = virtalloc_get_early_release_threshold(alloc);
+    const int n = 200 * 1024 / sizeof(int);
+    int *q;
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+    TEST_ASSERT_MSG(initial_threshold < n * sizeof(int), "the block should be bigger than the initial threshold");
+    TEST_ASSERT_MSG(((GPMemorySlotMeta *) q - 1)->meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT,
+                    "the block should have been released early");
+    ASSERT_CORRECT_CONTENT(q, n);
+    virtalloc_free(alloc, q);
+    TEST_ASSERT_MSG(virtalloc_get_early_release_threshold(alloc) > n * sizeof(int),
+                    "freeing the block should have raised the threshold above its size");
+
+    // the same size is now served from the heap and freeing it does not change the threshold anymore
+    for (int k = 0; k < 8; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+        TEST_ASSERT_MSG(((GPMemorySlotMeta *) q - 1)->meta_type == GP_META_TYPE_SLOT,
+                        "the block should have been served from the heap");
+        ASSERT_CORRECT_CONTENT(q, n);
+        const size_t threshold = virtalloc_get_early_release_threshold(alloc);
+        virtalloc_free(alloc, q);
+        TEST_ASSERT_MSG(virtalloc_get_early_release_threshold(alloc) == threshold, "the threshold should be stable");
+    }
+
+    // blocks at or above the upper bound never raise the threshold
+    virtalloc_set_early_release_threshold_bounds(alloc, initial_threshold, 3 * initial_threshold / 2);
+    TEST_ASSERT_MSG(virtalloc_get_early_release_threshold(alloc) == 3 * initial_threshold / 2,
+                    "the threshold should have been clamped to the upper bound");
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 3 * n / 2);
+    TEST_ASSERT_MSG(((GPMemorySlotMeta *) q - 1)->meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT,
+                    "the block should have been released early");
+    virtalloc_free(alloc, q);
+    TEST_ASSERT_MSG(virtalloc_get_early_release_threshold(alloc) == 3 * initial_threshold / 2,
+                    "the threshold must not exceed its upper bound");
+
+    // equal bounds fix the threshold
+    virtalloc_set_early_release_threshold_bounds(alloc, initial_threshold, initial_threshold);
+    TEST_ASSERT_MSG(virtalloc_get_early_release_threshold(alloc) == initial_threshold,
+                    "the threshold should have been lowered to the upper bound");
+    virtalloc_destroy_allocator(alloc);
+
+    // without the flag, the threshold is fixed
+    alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+    virtalloc_free(alloc, q);
+    TEST_ASSERT_MSG(virtalloc_get_early_release_threshold(alloc) == initial_threshold,
+                    "the threshold should be fixed without VIRTALLOC_FLAG_VA_DYNAMIC_EARLY_RELEASE");
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+static int num_memory_requests = 0;
+
+static void *counting_request_new_memory(const size_t min_size) {
+    num_memory_requests++;
+    return request_new_memory(min_size);
+}
+
+int test_early_release_cache_23() {
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS
+                                                       | VIRTALLOC_FLAG_VA_EARLY_RELEASE_CACHE);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    virtalloc_set_release_mechanism(alloc, release_memory);
+    virtalloc_set_request_mechanism(alloc, counting_request_new_memory);
+    num_memory_requests = 0;
+    // a bit less than a power of 2, so that the padding does not push the blocks into the next size class
+    const int n = (4 * 1024 * 1024 - 1024) / sizeof(int);
+    int *q, *q2;
+
+    // identical blocks are recycled instead of being requested again
+    for (int k = 0; k < 100; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+        TEST_ASSERT_MSG(((GPMemorySlotMeta *) q - 1)->meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT,
+                        "the block should have been released early");
+        ASSERT_CORRECT_CONTENT(q, n);
+        virtalloc_free(alloc, q);
+    }
+    TEST_ASSERT_MSG(num_memory_requests == 1, "only the first block should have been requested");
+
+    // blocks of another size class are not reused
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 2 * n);
+    TEST_ASSERT_MSG(num_memory_requests == 2, "a block of a different size class should have been requested");
+    virtalloc_free(alloc, q);
+
+    // the byte limit evicts the oldest blocks (which are the cached 4 MiB block and then the 8 MiB block here)
+    virtalloc_set_early_release_cache_limit(alloc, 3 * n * sizeof(int) / 2);
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q2, n);
+    TEST_ASSERT_MSG(num_memory_requests == 4, "the limit should have evicted all cached blocks");
+    virtalloc_free(alloc, q);
+    virtalloc_free(alloc, q2);
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q2, n);
+    TEST_ASSERT_MSG(num_memory_requests == 5, "the limit should only leave room for one cached block");
+    virtalloc_free(alloc, q2);
+
+    // blocks age out if they are not reused for a while
+    const int m = (256 * 1024 - 1024) / sizeof(int);
+    const int num_requests_before = num_memory_requests;
+    for (int k = 0; k < EARLY_RELEASE_CACHE_MAX_AGE; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q2, m);
+        virtalloc_free(alloc, q2);
+    }
+    TEST_ASSERT_MSG(num_memory_requests == num_requests_before + 1, "the smaller block should have been recycled");
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q2, n);
+    TEST_ASSERT_MSG(num_memory_requests == num_requests_before + 2, "the unused block should have aged out");
+    virtalloc_free(alloc, q2);
+    virtalloc_free(alloc, q);
+
+    // disabling the cache releases everything
+    virtalloc_set_early_release_cache_limit(alloc, 0);
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+    TEST_ASSERT_MSG(num_memory_requests == num_requests_before + 3, "the cache should have been emptied");
+    virtalloc_free(alloc, q);
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_early_release_size_classes_24() {
+    TEST_ASSERT_MSG(round_to_size_class(128 * 1024, 4) == 128 * 1024, "powers of 2 are size classes");
+    TEST_ASSERT_MSG(round_to_size_class(129 * 1024, 4) == 160 * 1024, "sizes should be rounded to quarter steps");
+    TEST_ASSERT_MSG(round_to_size_class(161 * 1024, 4) == 192 * 1024, "sizes should be rounded to quarter steps");
+    TEST_ASSERT_MSG(round_to_size_class(3, 4) == 4, "tiny sizes should be rounded to powers of 2");
+
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+    const int n = 130 * 1024 / sizeof(int);
+    int *q;
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+    const GPEarlyReleaseMeta *meta = (GPEarlyReleaseMeta *) q - 1;
+    TEST_ASSERT_MSG(meta->meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT, "the block should have been released early");
+    TEST_ASSERT_MSG(meta->size < 192 * 1024, "the block should not have been rounded to a power of 2");
+
+    // growing within the size class keeps the block in place
+    int *q2 = virtalloc_realloc(alloc, q, 150 * 1024);
+    TEST_ASSERT_MSG(q2 == q, "growing within the size class should not relocate the block");
+    ASSERT_CORRECT_CONTENT(q, n);
+
+    // growing beyond it relocates the block
+    q2 = virtalloc_realloc(alloc, q, 200 * 1024);
+    TEST_ASSERT_MSG(q2, "failed to grow block");
+    q = q2;
+    ASSERT_CORRECT_CONTENT(q, n);
+    meta = (GPEarlyReleaseMeta *) q - 1;
+    TEST_ASSERT_MSG(meta->size >= 200 * 1024 && meta->size < 256 * 1024, "the block should be in the 224 KiB class");
+    virtalloc_free(alloc, q);
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_remap_realloc_25() {
+    vap_t alloc = virtalloc_new_allocator(64 * 1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS
+                                                            | VIRTALLOC_FLAG_VA_OS_BACKEND | VIRTALLOC_FLAG_VA_AUTO_TRIM);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+    const int n = 1024 * 1024 / sizeof(int);
+    int *q, *q2;
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+    TEST_ASSERT_MSG(((GPEarlyReleaseMeta *) q - 1)->meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT,
+                    "the block should have been released early");
+
+    // growing a huge block moves its pages, the content stays intact
+    q2 = virtalloc_realloc(alloc, q, 256 * n * sizeof(int));
+    TEST_ASSERT_MSG(q2, "failed to grow block");
+    q = q2;
+    const GPEarlyReleaseMeta *meta = (GPEarlyReleaseMeta *) q - 1;
+    TEST_ASSERT_MSG(meta->meta_type == GP_META_TYPE_EARLY_RELEASE_SLOT && meta->size >= 256 * n * sizeof(int),
+                    "the grown block should be an early release block");
+    ASSERT_CORRECT_CONTENT(q, n);
+    q[256 * n - 1] = 42;
+
+    // shrinking it unmaps its tail in place
+    q2 = virtalloc_realloc(alloc, q, 2 * n * sizeof(int));
+    TEST_ASSERT_MSG(q2 == q, "shrinking a remappable block should not relocate it");
+    TEST_ASSERT_MSG(meta->size >= 2 * n * sizeof(int) && meta->size < 4 * n * sizeof(int),
+                    "the block should have been shrunk");
+    ASSERT_CORRECT_CONTENT(q, n);
+    virtalloc_free(alloc, q);
+
+    // shrinking a huge heap slot returns the pages of its tail to the OS
+    virtalloc_set_early_release_threshold_bounds(alloc, 1024 * 1024 * 1024, 1024 * 1024 * 1024);
+    MAKE_AUTO_INIT_INT_ALLOC_INTO(q, 48 * n);
+    TEST_ASSERT_MSG(((GPMemorySlotMeta *) q - 1)->meta_type == GP_META_TYPE_SLOT, "the slot should be in the heap");
+    q2 = virtalloc_realloc(alloc, q, n * sizeof(int));
+    TEST_ASSERT_MSG(q2 == q, "shrinking a heap slot should not relocate it");
+    const GPMemorySlotMeta *gp_meta = (GPMemorySlotMeta *) q - 1;
+    const GPMemorySlotMeta *tail_meta = gp_meta->next - sizeof(GPMemorySlotMeta);
+    TEST_ASSERT_MSG(tail_meta->is_free && tail_meta->is_decommitted, "the tail should have been decommitted");
+    for (int k = 0; k < n; k++)
+        TEST_ASSERT_MSG(q[k] == 48 * n + k, "shrinking should preserve the content");
+    virtalloc_free(alloc, q);
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_early_release_block_list_26() {
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+    const int n = 200 * 1024 / sizeof(int);
+    int *blocks[3], *q;
+    for (int k = 0; k < 3; k++) {
+        MAKE_AUTO_INIT_INT_ALLOC_INTO(q, n);
+        blocks[k] = q;
+    }
+    size_t num_blocks, num_bytes;
+    virtalloc_get_early_release_stats(alloc, &num_blocks, &num_bytes);
+    TEST_ASSERT_MSG(num_blocks == 3 && num_bytes >= 3 * n * sizeof(int), "all blocks should be tracked");
+
+    // removing a block from the middle of the list keeps the others intact
+    virtalloc_free(alloc, blocks[1]);
+    virtalloc_get_early_release_stats(alloc, &num_blocks, &num_bytes);
+    TEST_ASSERT_MSG(num_blocks == 2 && num_bytes >= 2 * n * sizeof(int), "the freed block should not be tracked");
+
+    // a block that moves when it is remapped stays tracked
+    q = virtalloc_realloc(alloc, blocks[2], 64 * n * sizeof(int));
+    TEST_ASSERT_MSG(q, "failed to grow block");
+    blocks[2] = q;
+    virtalloc_get_early_release_stats(alloc, &num_blocks, &num_bytes);
+    TEST_ASSERT_MSG(num_blocks == 2 && num_bytes >= 65 * n * sizeof(int), "the grown block should be tracked");
+    q = blocks[0];
+    ASSERT_CORRECT_CONTENT(q, n);
+    q = blocks[2];
+    ASSERT_CORRECT_CONTENT(q, n);
+
+    // the blocks show up in the dump
+    FILE *file = tmpfile();
+    TEST_ASSERT_MSG(file, "failed to create temporary file");
+    virtalloc_dump_allocator_to_file(file, alloc);
+    rewind(file);
+    char line[256];
+    int num_dumped_blocks = 0;
+    while (fgets(line, sizeof(line), file))
+        num_dumped_blocks += strstr(line, "EARLY RELEASE BLOCK ") != NULL;
+    fclose(file);
+    TEST_ASSERT_MSG(num_dumped_blocks == 2, "the dump should list both live blocks");
+
+    // destroying the allocator releases the blocks that are still allocated
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_calloc_27() {
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+    TEST_ASSERT_MSG(!virtalloc_calloc(alloc, SIZE_MAX / 2, 4), "overflowing calloc should fail");
+
+    // small, GPA and early release sizes, each first fresh and then reusing memory that was dirtied and freed
+    const size_t sizes[] = {24, 3000, 64 * 1024, 200 * 1024};
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        for (int round = 0; round < 2; round++) {
+            unsigned char *q = virtalloc_calloc(alloc, sizes[k], 1);
+            TEST_ASSERT_MSG(q, "calloc failed");
+            for (size_t j = 0; j < sizes[k]; j++)
+                TEST_ASSERT_MSG(q[j] == 0, "calloc returned memory that is not zeroed");
+            memset(q, 0xab, sizes[k]);
+            virtalloc_free(alloc, q);
+        }
+    }
+
+    // decommitted memory is known to be zero-filled, but the slot edges around it are not
+    unsigned char *q = virtalloc_malloc(alloc, 256 * 1024 - 4096);
+    TEST_ASSERT_MSG(q, "malloc failed");
+    memset(q, 0xcd, 256 * 1024 - 4096);
+    virtalloc_free(alloc, q);
+    virtalloc_trim(alloc, 0);
+    q = virtalloc_calloc(alloc, 1000, 100);
+    TEST_ASSERT_MSG(q, "calloc failed");
+    for (size_t j = 0; j < 1000 * 100; j++)
+        TEST_ASSERT_MSG(q[j] == 0, "calloc returned memory that is not zeroed after a trim");
+    virtalloc_free(alloc, q);
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_aligned_alloc_28() {
+    const int flag_sets[] = {
+        VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS,
+        VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND | VIRTALLOC_FLAG_VA_PAGE_MAP_CLASSIFICATION,
+    };
+    const size_t alignments[] = {8, 64, 128, 4096, 2 * 1024 * 1024};
+    const size_t sizes[] = {10, 3000, 100 * 1024, 1024 * 1024};
+    vap_t alloc = NULL;
+    for (size_t f = 0; f < sizeof(flag_sets) / sizeof(flag_sets[0]); f++) {
+        alloc = virtalloc_new_allocator(16 * 1024 * 1024, flag_sets[f]);
+        TEST_ASSERT_MSG(alloc, "failed to create allocator");
+        unsigned char *ptrs[sizeof(alignments) / sizeof(alignments[0])][sizeof(sizes) / sizeof(sizes[0])];
+        for (size_t a = 0; a < sizeof(alignments) / sizeof(alignments[0]); a++) {
+            for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+                unsigned char *q = virtalloc_aligned_alloc(alloc, alignments[a], sizes[k]);
+                TEST_ASSERT_MSG(q, "aligned allocation failed");
+                TEST_ASSERT_MSG((size_t) q % alignments[a] == 0, "pointer is not aligned");
+                memset(q, (int) (a * 16 + k), sizes[k]);
+                ptrs[a][k] = q;
+            }
+        }
+        for (size_t a = 0; a < sizeof(alignments) / sizeof(alignments[0]); a++) {
+            for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+                for (size_t j = 0; j < sizes[k]; j++)
+                    TEST_ASSERT_MSG(ptrs[a][k][j] == (unsigned char) (a * 16 + k), "aligned allocations overlap");
+                virtalloc_free(alloc, ptrs[a][k]);
+            }
+        }
+
+        void *q = NULL;
+        TEST_ASSERT_MSG(virtalloc_posix_memalign(alloc, &q, 24, 100) == EINVAL, "alignment must be a power of 2");
+        TEST_ASSERT_MSG(virtalloc_posix_memalign(alloc, &q, 4, 100) == EINVAL,
+                        "alignment must be a multiple of sizeof(void *)");
+        TEST_ASSERT_MSG(!virtalloc_aligned_alloc(alloc, 3, 100), "alignment must be a power of 2");
+        TEST_ASSERT_MSG(virtalloc_posix_memalign(alloc, &q, 256, 5000) == 0 && q && (size_t) q % 256 == 0,
+                        "posix_memalign failed");
+        virtalloc_free(alloc, q);
+        virtalloc_destroy_allocator(alloc);
+        alloc = NULL;
+    }
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_gpa_alignment_29() {
+    const int alignment_flags[] = {VIRTALLOC_FLAG_VA_GPA_ALIGN_16, VIRTALLOC_FLAG_VA_GPA_ALIGN_32};
+    const size_t alignments[] = {16, 32};
+    vap_t alloc = NULL;
+    for (size_t f = 0; f < sizeof(alignment_flags) / sizeof(alignment_flags[0]); f++) {
+        alloc = virtalloc_new_allocator(
+            1024 * 1024, (VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS & ~VIRTALLOC_FLAG_VA_HAS_SAFETY_PADDING_LINE)
+                         | VIRTALLOC_FLAG_VA_DENSE_CHECKSUM_CHECKS | alignment_flags[f]);
+        TEST_ASSERT_MSG(alloc, "failed to create allocator");
+
+        // consecutive slots are only padded to the selected alignment (plus the meta in between)
+        char *a = virtalloc_malloc(alloc, 72);
+        char *b = virtalloc_malloc(alloc, 72);
+        TEST_ASSERT_MSG(a && b, "malloc failed");
+        TEST_ASSERT_MSG((size_t) (b - a) == sizeof(GPMemorySlotMeta) + align_to(72, alignments[f]),
+                        "slot size should be rounded to the selected alignment");
+        virtalloc_free(alloc, a);
+        virtalloc_free(alloc, b);
+
+        // mixed operations keep the heap consistent and every pointer aligned
+        unsigned char *ptrs[64] = {0};
+        size_t sizes[64] = {0};
+        unsigned seed = 42;
+        for (int step = 0; step < 4000; step++) {
+            seed = seed * 1103515245 + 12345;
+            const int k = (int) (seed >> 8) % 64;
+            const size_t size = 65 + (seed >> 16) % 3000;
+            if (ptrs[k]) {
+                for (size_t j = 0; j < sizes[k]; j++)
+                    TEST_ASSERT_MSG(ptrs[k][j] == (unsigned char) k, "slot content was corrupted");
+                if (step % 3 == 0) {
+                    virtalloc_free(alloc, ptrs[k]);
+                    ptrs[k] = NULL;
+                    continue;
+                }
+                ptrs[k] = virtalloc_realloc(alloc, ptrs[k], size);
+            } else {
+                ptrs[k] = virtalloc_malloc(alloc, size);
+            }
+            TEST_ASSERT_MSG(ptrs[k], "allocation failed");
+            TEST_ASSERT_MSG((size_t) ptrs[k] % alignments[f] == 0, "pointer is not aligned");
+            memset(ptrs[k], k, size);
+            sizes[k] = size;
+        }
+        for (int k = 0; k < 64; k++)
+            if (ptrs[k])
+                virtalloc_free(alloc, ptrs[k]);
+        virtalloc_destroy_allocator(alloc);
+        alloc = NULL;
+    }
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_usable_size_30() {
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+    const size_t sizes[] = {10, 100, 1000, 5000, 300 * 1024};
+    unsigned char *ptrs[sizeof(sizes) / sizeof(sizes[0])];
+    size_t usable_sizes[sizeof(sizes) / sizeof(sizes[0])];
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        ptrs[k] = virtalloc_malloc_at_least(alloc, sizes[k], &usable_sizes[k]);
+        TEST_ASSERT_MSG(ptrs[k], "malloc_at_least failed");
+        TEST_ASSERT_MSG(usable_sizes[k] >= sizes[k], "usable size is smaller than the requested size");
+        TEST_ASSERT_MSG(usable_sizes[k] == virtalloc_usable_size(alloc, ptrs[k]), "usable sizes disagree");
+        // the whole usable size can be written without corrupting the neighbouring allocations
+        memset(ptrs[k], (int) k, usable_sizes[k]);
+    }
+    TEST_ASSERT_MSG(usable_sizes[0] == 63, "small slots have 63 usable bytes");
+
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        // growing into the usable size does not move or grow the allocation
+        unsigned char *q = virtalloc_realloc(alloc, ptrs[k], usable_sizes[k]);
+        TEST_ASSERT_MSG(q == ptrs[k], "realloc to the usable size moved the allocation");
+        TEST_ASSERT_MSG(virtalloc_usable_size(alloc, q) == usable_sizes[k], "realloc to the usable size resized it");
+        for (size_t j = 0; j < usable_sizes[k]; j++)
+            TEST_ASSERT_MSG(q[j] == (unsigned char) k, "allocations overlap");
+        virtalloc_free(alloc, q);
+    }
+
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_sized_and_trusted_free_31() {
+    const int flag_sets[] = {
+        VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND | VIRTALLOC_FLAG_VA_PAGE_MAP_CLASSIFICATION,
+        VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND | VIRTALLOC_FLAG_VA_TRUSTED_FREE,
+    };
+    const size_t sizes[] = {20, 1000, 300 * 1024};
+    vap_t alloc = NULL;
+    for (size_t f = 0; f < sizeof(flag_sets) / sizeof(flag_sets[0]); f++) {
+        alloc = virtalloc_new_allocator(1024 * 1024, flag_sets[f]);
+        TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+        for (int mode = 0; mode < 3; mode++) {
+            unsigned char *ptrs[sizeof(sizes) / sizeof(sizes[0])];
+            for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+                ptrs[k] = virtalloc_malloc(alloc, sizes[k]);
+                TEST_ASSERT_MSG(ptrs[k], "malloc failed");
+                memset(ptrs[k], (int) k, sizes[k]);
+            }
+            // SMA chunks may be early release blocks as well
+            size_t num_blocks_before, num_blocks, num_bytes;
+            virtalloc_get_early_release_stats(alloc, &num_blocks_before, &num_bytes);
+            for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+                for (size_t j = 0; j < sizes[k]; j++)
+                    TEST_ASSERT_MSG(ptrs[k][j] == (unsigned char) k, "allocations overlap");
+                if (mode == 0)
+                    virtalloc_free_sized(alloc, ptrs[k], sizes[k]);
+                else if (mode == 1)
+                    virtalloc_free_trusted(alloc, ptrs[k], sizes[k]);
+                else
+                    virtalloc_free(alloc, ptrs[k]);
+            }
+            virtalloc_get_early_release_stats(alloc, &num_blocks, &num_bytes);
+            TEST_ASSERT_MSG(num_blocks == num_blocks_before - 1, "the early release block should have been freed");
+        }
+
+        // the freed GPA slot is reused, so the sized free really freed it
+        void *q = virtalloc_malloc(alloc, 1000);
+        virtalloc_free_trusted(alloc, q, 1000);
+        void *q2 = virtalloc_malloc(alloc, 1000);
+        TEST_ASSERT_MSG(q == q2, "the slot freed by a trusted free should be reused");
+        virtalloc_free_trusted(alloc, q2, 0);
+        virtalloc_destroy_allocator(alloc);
+        alloc = NULL;
+    }
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_realloc_backwards_32() {
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024,
+                                          VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_NO_RR_ALLOCATOR
+                                          | VIRTALLOC_FLAG_VA_HEAVY_DEBUG_CORRUPTION_CHECKS);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    for (int grow_into_both = 0; grow_into_both < 2; grow_into_both++) {
+        unsigned char *ptrs[4];
+        for (int k = 0; k < 4; k++) {
+            ptrs[k] = virtalloc_malloc(alloc, 1000);
+            TEST_ASSERT_MSG(ptrs[k], "malloc failed");
+        }
+        TEST_ASSERT_MSG(ptrs[0] < ptrs[1] && ptrs[1] < ptrs[2] && ptrs[2] < ptrs[3],
+                        "expected consecutive allocations to be laid out in order");
+        memset(ptrs[1], 0xab, 1000);
+        virtalloc_free(alloc, ptrs[0]);
+        if (grow_into_both)
+            virtalloc_free(alloc, ptrs[2]);
+
+        size_t forwards_before, backwards_before, relocated_before, forwards, backwards, relocated;
+        virtalloc_get_realloc_stats(alloc, &forwards_before, &backwards_before, &relocated_before);
+        // too big for the predecessor alone, so growing into both neighbours is required in the second run
+        const size_t new_size = grow_into_both ? 2800 : 1800;
+        unsigned char *grown = virtalloc_realloc(alloc, ptrs[1], new_size);
+        TEST_ASSERT_MSG(grown == ptrs[0], "the slot should have grown into its free predecessor");
+        virtalloc_get_realloc_stats(alloc, &forwards, &backwards, &relocated);
+        TEST_ASSERT_MSG(backwards == backwards_before + 1 && forwards == forwards_before
+                        && relocated == relocated_before, "the realloc was not counted as grown backwards");
+        for (int j = 0; j < 1000; j++)
+            TEST_ASSERT_MSG(grown[j] == 0xab, "data was not preserved by growing backwards");
+        memset(grown, 0xcd, new_size);
+
+        virtalloc_free(alloc, grown);
+        if (!grow_into_both)
+            virtalloc_free(alloc, ptrs[2]);
+        virtalloc_free(alloc, ptrs[3]);
+    }
+
+    // without free neighbours, the data has to be relocated
+    void *a = virtalloc_malloc(alloc, 1000);
+    void *b = virtalloc_malloc(alloc, 1000);
+    void *c = virtalloc_malloc(alloc, 1000);
+    size_t relocated_before, relocated;
+    virtalloc_get_realloc_stats(alloc, NULL, NULL, &relocated_before);
+    void *b2 = virtalloc_realloc(alloc, b, 5000);
+    TEST_ASSERT_MSG(b2 && b2 != b, "the slot should have been relocated");
+    virtalloc_get_realloc_stats(alloc, NULL, NULL, &relocated);
+    TEST_ASSERT_MSG(relocated == relocated_before + 1, "the relocation was not counted");
+    virtalloc_free(alloc, a);
+    virtalloc_free(alloc, b2);
+    virtalloc_free(alloc, c);
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_try_expand_and_shrink_33() {
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS
+                                                       | VIRTALLOC_FLAG_VA_HEAVY_DEBUG_CORRUPTION_CHECKS);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    unsigned char *a = virtalloc_malloc(alloc, 1000);
+    unsigned char *b = virtalloc_malloc(alloc, 1000);
+    TEST_ASSERT_MSG(a && b && a < b, "expected consecutive allocations to be laid out in order");
+    memset(a, 0xab, 1000);
+
+    // the successor is allocated, so a can't grow, and a failed expand must not change anything
+    TEST_ASSERT_MSG(!virtalloc_try_expand(alloc, a, 2000), "expanded into an allocated neighbour");
+    TEST_ASSERT_MSG(virtalloc_usable_size(alloc, a) < 2000, "failed expand changed the allocation");
+    TEST_ASSERT_MSG(virtalloc_try_expand(alloc, a, 500), "expanding to a smaller size should succeed");
+
+    virtalloc_free(alloc, b);
+    TEST_ASSERT_MSG(virtalloc_try_expand(alloc, a, 3000), "expand into a free neighbour failed");
+    TEST_ASSERT_MSG(virtalloc_usable_size(alloc, a) >= 3000, "expand did not grow the allocation");
+    for (int j = 0; j < 1000; j++)
+        TEST_ASSERT_MSG(a[j] == 0xab, "data was not preserved by expanding");
+    memset(a, 0xcd, 3000);
+
+    TEST_ASSERT_MSG(!virtalloc_try_shrink(alloc, a, 5000), "shrinking to a bigger size should fail");
+    TEST_ASSERT_MSG(virtalloc_try_shrink(alloc, a, 1000), "shrink failed");
+    TEST_ASSERT_MSG(virtalloc_usable_size(alloc, a) < 3000, "shrink did not give back the tail");
+    // the tail was given back, so the next allocation can reuse it
+    unsigned char *c = virtalloc_malloc(alloc, 1000);
+    TEST_ASSERT_MSG(c && c > a && c < a + 3000, "the tail given back by shrink was not reused");
+    TEST_ASSERT_MSG(!virtalloc_try_expand(alloc, a, 3000), "expanded into an allocated neighbour");
+    for (int j = 0; j < 1000; j++)
+        TEST_ASSERT_MSG(a[j] == 0xcd, "data was not preserved by shrinking");
+
+    // RR slots have a fixed size
+    void *small = virtalloc_malloc(alloc, 10);
+    TEST_ASSERT_MSG(virtalloc_try_expand(alloc, small, virtalloc_usable_size(alloc, small)),
+                    "expanding a small slot to its usable size failed");
+    TEST_ASSERT_MSG(!virtalloc_try_expand(alloc, small, 1000), "expanded a small slot beyond its size");
+
+    virtalloc_free(alloc, small);
+    virtalloc_free(alloc, c);
+    virtalloc_free(alloc, a);
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_relocation_copy_34() {
+    const size_t size = NON_TEMPORAL_COPY_MIN_SIZE + 333;
+    unsigned char *src = malloc(size + 64);
+    unsigned char *dst = malloc(size + 64);
+    TEST_ASSERT_MSG(src && dst, "failed to allocate buffers");
+    for (size_t i = 0; i < size + 64; i++)
+        src[i] = (unsigned char) (i * 31 + 7);
+    // unaligned source and destination and sizes around the threshold of the non-temporal copy
+    const size_t offsets[][2] = {{0, 0}, {1, 3}, {17, 0}, {0, 45}};
+    const size_t sizes[] = {size, size - 1000, NON_TEMPORAL_COPY_MIN_SIZE, 100};
+    for (size_t k = 0; k < sizeof(offsets) / sizeof(offsets[0]); k++) {
+        memset(dst, 0, size + 64);
+        relocation_copy(dst + offsets[k][0], src + offsets[k][1], sizes[k]);
+        for (size_t i = 0; i < offsets[k][0]; i++)
+            TEST_ASSERT_MSG(dst[i] == 0, "relocation copy wrote before the destination");
+        TEST_ASSERT_MSG(memcmp(dst + offsets[k][0], src + offsets[k][1], sizes[k]) == 0,
+                        "relocation copy produced a wrong copy");
+        for (size_t i = offsets[k][0] + sizes[k]; i < size + 64; i++)
+            TEST_ASSERT_MSG(dst[i] == 0, "relocation copy wrote past the destination");
+    }
+    // copies smaller than the unaligned head plus one block must not stream anything
+    for (size_t n = 0; n < 300; n += 7) {
+        memset(dst, 0, n + 64);
+        non_temporal_copy(dst + 1, src, n);
+        TEST_ASSERT_MSG(dst[0] == 0 && memcmp(dst + 1, src, n) == 0, "small non-temporal copy produced a wrong copy");
+        for (size_t i = n + 1; i < n + 64; i++)
+            TEST_ASSERT_MSG(dst[i] == 0, "small non-temporal copy wrote past the destination");
+    }
+    free(src);
+    free(dst);
+    return 0;
+fail:
+    free(src);
+    free(dst);
+    return 1;
+}
+
+int test_realloc_growth_headroom_35() {
+    vap_t alloc = virtalloc_new_allocator(4 * 1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS
+                                                           | VIRTALLOC_FLAG_VA_NO_RR_ALLOCATOR
+                                                           | VIRTALLOC_FLAG_VA_DENSE_CHECKSUM_CHECKS);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    void *blockers[16];
+    const size_t num_steps = sizeof(blockers) / sizeof(blockers[0]);
+    size_t size = 256;
+    unsigned char *buf = virtalloc_malloc(alloc, size);
+    memset(buf, 0x5a, size);
+    size_t relocated_before, relocated;
+    virtalloc_get_realloc_stats(alloc, NULL, NULL, &relocated_before);
+    for (size_t step = 0; step < num_steps; step++) {
+        // the blocker is placed right after the buffer, so growing without headroom would have to relocate
+        blockers[step] = virtalloc_malloc(alloc, 100);
+        TEST_ASSERT_MSG(blockers[step], "malloc failed");
+        const size_t new_size = size + size / 2;
+        buf = virtalloc_realloc(alloc, buf, new_size);
+        TEST_ASSERT_MSG(buf, "realloc failed");
+        for (size_t j = 0; j < size; j++)
+            TEST_ASSERT_MSG(buf[j] == 0x5a, "data was not preserved by growing");
+        memset(buf, 0x5a, new_size);
+        size = new_size;
+    }
+    virtalloc_get_realloc_stats(alloc, NULL, NULL, &relocated);
+    TEST_ASSERT_MSG(relocated - relocated_before <= num_steps / 2,
+                    "geometric growth should mostly be served from the reserved headroom");
+
+    // shrinking gives the headroom back
+    TEST_ASSERT_MSG(virtalloc_usable_size(alloc, buf) > size, "no headroom was reserved");
+    buf = virtalloc_realloc(alloc, buf, 1000);
+    TEST_ASSERT_MSG(buf && virtalloc_usable_size(alloc, buf) < 1100, "shrinking did not release the headroom");
+    for (int j = 0; j < 1000; j++)
+        TEST_ASSERT_MSG(buf[j] == 0x5a, "data was not preserved by shrinking");
+
+    virtalloc_free(alloc, buf);
+    for (size_t step = 0; step < num_steps; step++)
+        virtalloc_free(alloc, blockers[step]);
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_arena_36() {
+    vap_t alloc = virtalloc_new_allocator(4 * 1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS
+                                                       | VIRTALLOC_FLAG_VA_HEAVY_DEBUG_CORRUPTION_CHECKS);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    vaarena_t arena = virtalloc_arena_create(alloc, 4096);
+    TEST_ASSERT_MSG(arena, "failed to create arena");
+    TEST_ASSERT_MSG(virtalloc_arena_mark(arena) == NULL, "an empty arena should have a NULL mark");
+
+    unsigned char *first = virtalloc_arena_alloc(arena, 24);
+    unsigned char *second = virtalloc_arena_alloc(arena, 7);
+    TEST_ASSERT_MSG(first && second && second == first + 32, "arena allocations should be bumped");
+    TEST_ASSERT_MSG((size_t) second % 16 == 0, "arena allocations should be 16 byte aligned");
+    TEST_ASSERT_MSG(!virtalloc_arena_alloc(arena, SIZE_MAX), "arena allocation of SIZE_MAX bytes should fail");
+    TEST_ASSERT_MSG(!virtalloc_arena_alloc(arena, SIZE_MAX - 16), "arena allocation size overflow was not caught");
+    TEST_ASSERT_MSG(!virtalloc_arena_realloc(arena, second, 7, SIZE_MAX), "arena realloc size overflow was not caught");
+
+    // the most recent allocation grows in place, others are copied
+    memset(second, 0xab, 7);
+    TEST_ASSERT_MSG(virtalloc_arena_realloc(arena, second, 7, 100) == second, "realloc of the last allocation moved");
+    memset(first, 0xcd, 24);
+    unsigned char *first_grown = virtalloc_arena_realloc(arena, first, 24, 48);
+    TEST_ASSERT_MSG(first_grown && first_grown != first, "realloc of an older allocation should copy");
+    for (int j = 0; j < 24; j++)
+        TEST_ASSERT_MSG(first_grown[j] == 0xcd, "arena realloc did not preserve the data");
+    // shrinking an older allocation neither moves it nor takes arena space
+    void *cursor = virtalloc_arena_mark(arena);
+    TEST_ASSERT_MSG(virtalloc_arena_realloc(arena, second, 100, 20) == second
+                    && virtalloc_arena_mark(arena) == cursor, "shrinking an older allocation moved it");
+    for (int j = 0; j < 7; j++)
+        TEST_ASSERT_MSG(second[j] == 0xab, "shrinking an older allocation did not preserve the data");
+
+    void *mark = virtalloc_arena_mark(arena);
+    // spans many chunks, including one allocation too big for a regular chunk
+    for (int i = 0; i < 1000; i++) {
+        unsigned char *p = virtalloc_arena_alloc(arena, 40 + i % 100);
+        TEST_ASSERT_MSG(p, "arena allocation failed");
+        memset(p, i, 40 + i % 100);
+    }
+    unsigned char *big = virtalloc_arena_alloc(arena, 100000);
+    TEST_ASSERT_MSG(big, "big arena allocation failed");
+    memset(big, 1, 100000);
+
+    virtalloc_arena_reset_to_mark(arena, mark);
+    TEST_ASSERT_MSG(virtalloc_arena_alloc(arena, 16) == mark, "reset did not roll the arena back to the mark");
+    for (int j = 0; j < 7; j++)
+        TEST_ASSERT_MSG(second[j] == 0xab, "reset freed allocations made before the mark");
+
+    virtalloc_arena_reset_to_mark(arena, NULL);
+    TEST_ASSERT_MSG(virtalloc_arena_mark(arena) == NULL, "reset to NULL should free all chunks");
+    TEST_ASSERT_MSG(virtalloc_arena_alloc(arena, 16), "arena allocation after reset failed");
+    virtalloc_arena_destroy(arena);
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_pool_37() {
+    vap_t alloc = virtalloc_new_allocator(4 * 1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS
+                                                       | VIRTALLOC_FLAG_VA_HEAVY_DEBUG_CORRUPTION_CHECKS);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator");
+    TEST_ASSERT_MSG(!virtalloc_pool_create(alloc, 48, 24), "alignment that is not a power of 2 should be rejected");
+    TEST_ASSERT_MSG(!virtalloc_pool_create(alloc, POOL_SLAB_SIZE, 16), "object bigger than a slab should be rejected");
+
+    static const size_t object_sizes[] = {48, 80, 112};
+    static void *objects[3000];
+    for (int k = 0; k < 3; k++) {
+        const size_t size = object_sizes[k];
+        vapool_t pool = virtalloc_pool_create(alloc, size, 16);
+        TEST_ASSERT_MSG(pool, "failed to create pool");
+        // enough objects to fill several slabs
+        for (int i = 0; i < 3000; i++) {
+            objects[i] = virtalloc_pool_alloc(pool);
+            TEST_ASSERT_MSG(objects[i], "pool allocation failed");
+            TEST_ASSERT_MSG((size_t) objects[i] % 16 == 0, "pool object is not aligned");
+            memset(objects[i], i, size);
+        }
+        TEST_ASSERT_MSG((unsigned char *) objects[1] == (unsigned char *) objects[0] + size,
+                        "pool objects should be packed densely");
+        TEST_ASSERT_MSG(((Pool *) pool)->num_slabs == (3000 + ((Pool *) pool)->objects_per_slab - 1)
+                        / ((Pool *) pool)->objects_per_slab, "pool uses more slabs than needed");
+        for (int i = 0; i < 3000; i++)
+            for (size_t j = 0; j < size; j++)
+                TEST_ASSERT_MSG(((unsigned char *) objects[i])[j] == (unsigned char) i, "pool objects overlap");
+
+        // freed objects are reused first
+        virtalloc_pool_free(pool, objects[5]);
+        TEST_ASSERT_MSG(virtalloc_pool_alloc(pool) == objects[5], "freed pool object was not reused");
+
+        for (int i = 0; i < 3000; i++)
+            virtalloc_pool_free(pool, objects[i]);
+        TEST_ASSERT_MSG(((Pool *) pool)->num_slabs == 1, "empty slabs should be returned to the allocator");
+        TEST_ASSERT_MSG(virtalloc_pool_alloc(pool), "pool allocation after freeing everything failed");
+        virtalloc_pool_destroy(pool);
+    }
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
+int test_usable_size_padding_boundary_38() {
+    vap_t alloc = virtalloc_new_allocator(1024 * 1024, VIRTALLOC_FLAG_VA_DEFAULT_SETTINGS | VIRTALLOC_FLAG_VA_OS_BACKEND);
+    TEST_ASSERT_MSG(alloc, "failed to create allocator with the OS backend");
+    // requests just below MIN_SIZE_FOR_SAFETY_PADDING are not padded but may share a slot size with padded ones
+    for (size_t size = MIN_SIZE_FOR_SAFETY_PADDING - 128; size < MIN_SIZE_FOR_SAFETY_PADDING + 256; size++) {
+        size_t usable_size;
+        unsigned char *p = virtalloc_malloc_at_least(alloc, size, &usable_size);
+        TEST_ASSERT_MSG(p, "malloc_at_least failed");
+        TEST_ASSERT_MSG(usable_size >= size, "usable size is smaller than the requested size");
+        TEST_ASSERT_MSG(usable_size == virtalloc_usable_size(alloc, p), "usable sizes disagree");
+        memset(p, 0xab, usable_size);
+        unsigned char *q = virtalloc_realloc(alloc, p, usable_size);
+        TEST_ASSERT_MSG(q == p && virtalloc_usable_size(alloc, q) == usable_size,
+                        "realloc to the usable size resized the allocation");
+        virtalloc_free(alloc, q);
+    }
+    virtalloc_destroy_allocator(alloc);
+    return 0;
+fail:
+    if (alloc)
+        virtalloc_destroy_allocator(alloc);
+    return 1;
+}
+
 BEGIN_RUNNER_SETTINGS()
     suppress_test_status = 1;
     print_on_all_passed_this_iter = 0;
@@ -659,6 +1993,32 @@ BEGIN_TEST_LIST()
     REGISTER_TEST_CASE(monolithic_test_rr_10)
     REGISTER_TEST_CASE(monolithic_test_rr_11)
     REGISTER_TEST_CASE(test_fragmentation_and_operations_12)
+    REGISTER_TEST_CASE(test_page_map_classification_13)
+    REGISTER_TEST_CASE(test_adaptive_exploration_14)
+    REGISTER_TEST_CASE(test_per_thread_sma_15)
+    REGISTER_TEST_CASE(test_split_locks_16)
+    REGISTER_TEST_CASE(test_try_malloc_and_free_17)
+    REGISTER_TEST_CASE(test_os_backend_18)
+    REGISTER_TEST_CASE(test_reserved_address_space_19)
+    REGISTER_TEST_CASE(test_trim_20)
+    REGISTER_TEST_CASE(test_scavenger_21)
+    REGISTER_TEST_CASE(test_dynamic_early_release_22)
+    REGISTER_TEST_CASE(test_early_release_cache_23)
+    REGISTER_TEST_CASE(test_early_release_size_classes_24)
+    REGISTER_TEST_CASE(test_remap_realloc_25)
+    REGISTER_TEST_CASE(test_early_release_block_list_26)
+    REGISTER_TEST_CASE(test_calloc_27)
+    REGISTER_TEST_CASE(test_aligned_alloc_28)
+    REGISTER_TEST_CASE(test_gpa_alignment_29)
+    REGISTER_TEST_CASE(test_usable_size_30)
+    REGISTER_TEST_CASE(test_sized_and_trusted_free_31)
+    REGISTER_TEST_CASE(test_realloc_backwards_32)
+    REGISTER_TEST_CASE(test_try_expand_and_shrink_33)
+    REGISTER_TEST_CASE(test_relocation_copy_34)
+    REGISTER_TEST_CASE(test_realloc_growth_headroom_35)
+    REGISTER_TEST_CASE(test_arena_36)
+    REGISTER_TEST_CASE(test_pool_37)
+    REGISTER_TEST_CASE(test_usable_size_padding_boundary_38)
 END_TEST_LIST()
 
 MAKE_TEST_SUITE_RUNNABLE()